@@ -49,7 +49,7 @@ application::application(const std::string& title, int width, int height)
     init_sdl();
     init_imgui();
     m_editor = std::make_unique<editor>();
-    m_editor->init(m_pref_dir, m_ui_scale);
+    m_editor->init(m_pref_dir, m_ui_scale, m_renderer);
 }
 
 application::~application() {
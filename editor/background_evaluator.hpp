@@ -0,0 +1,161 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include <level_synth/cancel_token.hpp>
+#include <level_synth/eval_engine.hpp>
+#include <level_synth/node_graph.hpp>
+#include <level_synth/pin.hpp>
+
+// ---------------------------------------------------------------------------
+// background_evaluator — evaluates graph snapshots off the UI thread
+//
+// request() copies the graph and hands the copy to a worker thread, so the
+// UI can keep editing while it runs. Requests coalesce: only the newest one
+// waiting is kept, and a new request cancels the evaluation in progress.
+// Cancelled work isn't lost; the worker's engine keeps the nodes that
+// finished, so the next evaluation reuses them.
+//
+// Finished evaluations are published as immutable results. latest() hands
+// out the current one, which stays valid however many newer ones arrive.
+// ---------------------------------------------------------------------------
+
+class background_evaluator {
+public:
+    struct result {
+        uint64_t    generation = 0;     // request() number it came from
+        std::string error;              // what evaluate() threw, if anything
+        std::unordered_map<int, std::unordered_map<std::string, ls::pin_value>> outputs;
+        std::unordered_map<int, ls::eval_engine::node_stats> stats;
+
+        const ls::pin_value* get_output(int node_id, const std::string& pin_name) const {
+            auto n = outputs.find(node_id);
+            if (n == outputs.end()) return nullptr;
+            auto p = n->second.find(pin_name);
+            return p != n->second.end() ? &p->second : nullptr;
+        }
+    };
+
+    // `on_result` runs on the worker thread after each published result,
+    // e.g. to wake an idle UI loop.
+    explicit background_evaluator(std::function<void()> on_result = {})
+        : m_on_result(std::move(on_result)),
+          m_worker([this] { run(); }) {}
+
+    ~background_evaluator() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+            m_running.cancel();
+        }
+        m_wake.notify_one();
+        m_worker.join();
+    }
+
+    background_evaluator(const background_evaluator&) = delete;
+    background_evaluator& operator=(const background_evaluator&) = delete;
+
+    // Snapshot `graph` and evaluate the snapshot on the worker, replacing
+    // any request still waiting and cancelling the one running.
+    void request(const ls::node_graph& graph, int seed) {
+        // Rebuilt here rather than on the worker, so node types are looked
+        // up on the thread that registers them (plugins load lazily).
+        auto snapshot = std::make_unique<ls::node_graph>();
+        snapshot->load_binary(graph.save_binary());
+        {
+            std::lock_guard lock(m_mutex);
+            m_pending = job{ ++m_requested, std::move(snapshot), seed };
+            m_running.cancel();
+        }
+        m_wake.notify_one();
+    }
+
+    // The most recent finished evaluation, null before the first.
+    std::shared_ptr<const result> latest() const {
+        std::lock_guard lock(m_mutex);
+        return m_latest;
+    }
+
+    // True while a request is waiting or running.
+    bool busy() const {
+        std::lock_guard lock(m_mutex);
+        return m_pending || m_busy;
+    }
+
+private:
+    struct job {
+        uint64_t generation;
+        std::unique_ptr<ls::node_graph> graph;
+        int seed;
+    };
+
+    void run() {
+        ls::eval_engine engine;     // kept across jobs for its cache
+        // Any node may be picked for preview, so every node needs outputs;
+        // fused chains keep only the last node's.
+        engine.set_fuse_pointwise(false);
+        for (;;) {
+            std::optional<job> next;
+            ls::cancel_token cancel;
+            {
+                std::unique_lock lock(m_mutex);
+                m_busy = false;
+                m_wake.wait(lock, [&] { return m_stop || m_pending; });
+                if (m_stop) return;
+                next = std::move(m_pending);
+                m_pending.reset();
+                m_running = cancel;
+                m_busy = true;
+            }
+            const auto& graph = next->graph;
+
+            auto res = std::make_shared<result>();
+            res->generation = next->generation;
+            try {
+                if (!engine.evaluate(*graph, next->seed, cancel))
+                    continue;                       // superseded
+                for (int id : graph->node_ids()) {
+                    auto& outs = res->outputs[id];
+                    for (const auto& pin : graph->find_node(id)->descriptor().pins)
+                        if (const auto* v = engine.get_output(id, pin.name))
+                            outs.emplace(pin.name, *v);
+                }
+                res->stats = engine.last_node_stats();
+            } catch (const std::exception& e) {
+                res->error = e.what();
+                res->outputs.clear();
+                res->stats.clear();
+            }
+
+            {
+                std::lock_guard lock(m_mutex);
+                m_latest = std::move(res);
+                m_busy = false;     // before waking the UI, so it sees both
+            }
+            if (m_on_result) m_on_result();
+        }
+    }
+
+    std::function<void()> m_on_result;
+
+    mutable std::mutex m_mutex;     // guards everything below
+    std::condition_variable m_wake;
+    std::optional<job> m_pending;
+    ls::cancel_token m_running;     // of the evaluation in progress
+    std::shared_ptr<const result> m_latest;
+    uint64_t m_requested = 0;
+    bool m_busy = false;
+    bool m_stop = false;
+
+    std::thread m_worker;           // last, so it starts after the rest
+};
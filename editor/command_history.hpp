@@ -1,34 +1,142 @@
 #pragma once
 
+#include <deque>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <level_synth/graph_delta.hpp>
 #include <level_synth/node_graph.hpp>
 
+#include "snapshot_store.hpp"
+
 // ---------------------------------------------------------------------------
-// snapshot_command — an undoable edit stored as before/after graph JSON
+// history_command — an undoable edit
+//
+// A structural delta (changed fields, added/removed nodes and wires) applied
+// in place. Nodes with state outside accept() additionally get that state
+// snapshotted through node::save_state(), per node and only where it
+// changed, and restored once the delta has put the node back.
 // ---------------------------------------------------------------------------
 
-struct snapshot_command {
-    std::string description;
-    std::string before_json;
-    std::string after_json;
+struct history_command {
+    using node_snapshot = std::pair<int, snapshot_store::handle>;
+
+    std::string                description;
+    ls::graph_delta            delta;
+    std::vector<node_snapshot> before;     // opaque state to restore on undo
+    std::vector<node_snapshot> after;      // opaque state to restore on redo
+
+    void undo(ls::node_graph& graph) const {
+        delta.undo(graph);
+        restore(graph, before);
+    }
+
+    void redo(ls::node_graph& graph) const {
+        delta.redo(graph);
+        restore(graph, after);
+    }
+
+    /// Memory of this entry alone, counting any snapshots in full even if
+    /// they are shared with neighbours.
+    size_t bytes() const {
+        size_t n = own_bytes();
+        for_each_snapshot([&](const snapshot_store::handle& h) { n += h->bytes(); });
+        return n;
+    }
+
+    /// bytes() without the snapshots.
+    size_t own_bytes() const {
+        return sizeof(*this) + description.capacity() + delta.bytes()
+             + (before.capacity() + after.capacity()) * sizeof(node_snapshot);
+    }
+
+    template <typename F>
+    void for_each_snapshot(F&& f) const {
+        for (const auto* side : { &before, &after })
+            for (const auto& [_, h] : *side) f(h);
+    }
 
-    void undo(ls::node_graph& graph) { graph.load(before_json); }
-    void redo(ls::node_graph& graph) { graph.load(after_json); }
+private:
+    static void restore(ls::node_graph& graph, const std::vector<node_snapshot>& states) {
+        for (const auto& [id, h] : states)
+            if (auto* n = graph.find_node(id)) n->load_state(snapshot_store::load(h));
+    }
+};
+
+// ---------------------------------------------------------------------------
+// edit_capture — records the graph before an edit and builds its command
+// ---------------------------------------------------------------------------
+
+class edit_capture {
+public:
+    void begin(const ls::node_graph& graph) {
+        m_before = ls::graph_state::capture(graph);
+        m_active = true;
+    }
+
+    bool active() const { return m_active; }
+
+    /// The command for everything that changed since begin(), or nullopt if
+    /// nothing did. Ends the capture either way.
+    std::optional<history_command> finish(std::string description, const ls::node_graph& graph,
+                                          snapshot_store& store) {
+        if (!m_active) return std::nullopt;
+        m_active = false;
+
+        const auto after = ls::graph_state::capture(graph);
+        history_command cmd{ std::move(description), ls::graph_delta::diff(m_before, after), {}, {} };
+        changed_states(m_before, after, store, cmd.before);
+        changed_states(after, m_before, store, cmd.after);
+        m_before = {};
+        if (cmd.delta.empty() && cmd.before.empty() && cmd.after.empty())
+            return std::nullopt;
+        return cmd;
+    }
+
+    void reset() {
+        m_before = {};
+        m_active = false;
+    }
+
+private:
+    // Opaque states in `from` that differ from (or are missing in) `to`.
+    static void changed_states(const ls::graph_state& from, const ls::graph_state& to,
+                               snapshot_store& store, std::vector<history_command::node_snapshot>& out) {
+        for (const auto& [id, state] : from.opaque) {
+            auto it = to.opaque.find(id);
+            if (it == to.opaque.end() || it->second != state)
+                out.emplace_back(id, store.intern(state));
+        }
+    }
+
+    ls::graph_state m_before;
+    bool            m_active = false;
 };
 
 // ---------------------------------------------------------------------------
 // command_history
+//
+// Bounded by a memory limit: once the entries together exceed it, the oldest
+// undo entries are dropped (the newest entry is always kept).
 // ---------------------------------------------------------------------------
 
 class command_history {
 public:
-    void push(snapshot_command cmd) {
-        m_stack.erase(m_stack.begin() + m_pos, m_stack.end());
+    static constexpr size_t k_default_memory_limit = size_t(64) << 20;
+
+    void push(history_command cmd) {
+        while (static_cast<int>(m_stack.size()) > m_pos) {
+            forget(m_stack.back());
+            m_stack.pop_back();
+        }
         m_stack.push_back(std::move(cmd));
+        count(m_stack.back());
         ++m_pos;
         if (m_saved_pos > m_pos) m_saved_pos = -1;
+        trim();
     }
 
     void undo(ls::node_graph& graph) {
@@ -46,20 +154,75 @@ public:
 
     void clear() {
         m_stack.clear();
+        m_snapshots.clear();
+        m_snapshot_refs.clear();
+        m_bytes     = 0;
         m_pos       = 0;
         m_saved_pos = 0;
     }
 
     bool is_modified() const { return m_pos != m_saved_pos; }
 
+    /// Cap on bytes(); 0 means unlimited. Applies immediately.
+    void set_memory_limit(size_t limit) {
+        m_memory_limit = limit;
+        trim();
+    }
+
+    size_t memory_limit() const { return m_memory_limit; }
+
+    /// Memory held by all entries, including redo entries. Snapshots shared
+    /// between entries are counted once.
+    size_t bytes() const { return m_bytes; }
+
+    /// Where edit captures intern their snapshots.
+    snapshot_store& snapshots() { return m_snapshots; }
+
     // Read-only access for the history panel
     int size()      const { return static_cast<int>(m_stack.size()); }
     int pos()       const { return m_pos; }
     int saved_pos() const { return m_saved_pos; }
-    const snapshot_command& entry(int i) const { return m_stack[i]; }
+    const history_command& entry(int i) const { return m_stack[i]; }
 
 private:
-    std::vector<snapshot_command> m_stack;
+    // Drops the oldest undo entries until under the limit. The saved
+    // position moves with them; once the saved state itself is dropped it
+    // can't be reached by undo any more.
+    void trim() {
+        if (m_memory_limit == 0) return;
+        while (m_pos > 0 && m_stack.size() > 1 && m_bytes > m_memory_limit) {
+            forget(m_stack.front());
+            m_stack.pop_front();
+            --m_pos;
+            if (m_saved_pos >= 0) --m_saved_pos;
+        }
+    }
+
+    // Keep bytes() current as entries come and go. A snapshot shared by
+    // several entries is counted while any of them holds it.
+    void count(const history_command& c) {
+        m_bytes += c.own_bytes();
+        c.for_each_snapshot([&](const snapshot_store::handle& h) {
+            if (m_snapshot_refs[h.get()]++ == 0) m_bytes += h->bytes();
+        });
+    }
+
+    void forget(const history_command& c) {
+        m_bytes -= c.own_bytes();
+        c.for_each_snapshot([&](const snapshot_store::handle& h) {
+            auto it = m_snapshot_refs.find(h.get());
+            if (--it->second == 0) {
+                m_bytes -= h->bytes();
+                m_snapshot_refs.erase(it);
+            }
+        });
+    }
+
+    std::deque<history_command> m_stack;
+    snapshot_store m_snapshots;
+    std::unordered_map<const snapshot_store::blob*, int> m_snapshot_refs;
+    size_t m_bytes = 0;
     int m_pos       = 0;
     int m_saved_pos = 0;
+    size_t m_memory_limit = k_default_memory_limit;
 };
@@ -1,4 +1,5 @@
 #include "editor.hpp"
+#include "application.hpp"
 #include "imgui_visitor.hpp"
 #include "phosphor_icons.hpp"
 #include <imgui_node_editor_node_builder.h>
@@ -43,8 +44,46 @@ namespace {
         snprintf(s_ph_buf, sizeof(s_ph_buf), "%s  %s###%s", icon, name, name);
         return s_ph_buf;
     }
+
+    std::string format_us(double us) {
+        char buf[32];
+        if      (us < 1000.0)    snprintf(buf, sizeof(buf), "%.0f us", us);
+        else if (us < 1000000.0) snprintf(buf, sizeof(buf), "%.2f ms", us / 1000.0);
+        else                     snprintf(buf, sizeof(buf), "%.2f s", us / 1000000.0);
+        return buf;
+    }
+
+    std::string format_bytes(size_t bytes) {
+        char buf[32];
+        if      (bytes < 1024)        snprintf(buf, sizeof(buf), "%zu B", bytes);
+        else if (bytes < 1024 * 1024) snprintf(buf, sizeof(buf), "%.0f KB", bytes / 1024.0);
+        else                          snprintf(buf, sizeof(buf), "%.1f MB", bytes / (1024.0 * 1024.0));
+        return buf;
+    }
+
+    // One line for a node's footer: what the last evaluation did with it.
+    std::string format_node_stats(const eval_profile::entry& e) {
+        using outcome = ls::eval_engine::node_stats::outcome;
+        std::string s;
+        switch (e.last.result) {
+            case outcome::evaluated: s = format_us(e.last.us); break;
+            case outcome::failed:    s = "failed  " + format_us(e.last.us); break;
+            case outcome::fused:     return "fused";
+            case outcome::reused:
+            case outcome::merged:
+                s = e.last.result == outcome::reused ? "cached" : "shared";
+                if (e.runs) s += " (" + format_us(e.mean_us()) + ")";
+                break;
+        }
+        if (e.last.output_bytes) s += "  \xc2\xb7  " + format_bytes(e.last.output_bytes);
+        return s;
+    }
 }
 
+editor::editor()
+    : m_evaluator([] { application::request_redraw(); }),
+      m_grid_viewer([] { application::request_redraw(); }) {}
+
 editor::~editor() {
     if (m_node_editor_context) {
         ed::DestroyEditor(m_node_editor_context);
@@ -52,11 +91,20 @@ editor::~editor() {
     }
 }
 
-void editor::init(const std::string& pref_dir, float ui_scale) {
+void editor::init(const std::string& pref_dir, float ui_scale, SDL_Renderer* renderer) {
     m_pref_dir = pref_dir;
     m_ui_scale = ui_scale;
+    m_grid_textures.set_renderer(renderer);
+    m_grid_viewer.set_renderer(renderer);
     m_node_editor_settings_path = m_pref_dir + "node_editor.json";
 
+    // Plugin manifests only; libraries load when a graph or the add-node
+    // menu first asks for one of their types.
+    if (const char* base = SDL_GetBasePath())
+        m_plugins.scan(std::filesystem::path(base) / "plugins");
+    m_plugins.scan(std::filesystem::path(m_pref_dir) / "plugins");
+    m_plugins.install();
+
     ax::NodeEditor::Config config;
     config.SettingsFile = m_node_editor_settings_path.c_str();
     config.EnableSmoothZoom = false;
@@ -83,7 +131,7 @@ void editor::init(const std::string& pref_dir, float ui_scale) {
 
 
     m_generator.set_seed(42);
-    m_generator.evaluate();
+    request_evaluation();
     load_preferences();
     resolve_theme();
     apply_theme();
@@ -109,7 +157,18 @@ void editor::on_system_theme_changed(bool dark) {
     apply_theme();
 }
 
+void editor::request_evaluation() {
+    m_evaluator.request(m_generator.graph(), m_generator.seed());
+}
+
 void editor::draw() {
+    // One result for the whole frame, however many arrive while drawing.
+    m_result = m_evaluator.latest();
+    if (m_result && m_result->generation != m_profiled_generation) {
+        m_profiled_generation = m_result->generation;
+        if (m_result->error.empty()) m_profile.add(m_result->stats);
+    }
+
     // Keyboard shortcuts (skip when a text field has focus)
     if (!ImGui::GetIO().WantTextInput) {
         auto& graph = m_generator.graph();
@@ -120,14 +179,14 @@ void editor::draw() {
                 m_history.redo(graph);
                 m_positioned_nodes.clear();
                 rebuild_links_from_graph();
-                m_generator.evaluate();
+                request_evaluation();
             }
         } else if (ImGui::IsKeyChordPressed(ImGuiMod_Shortcut | ImGuiKey_Z)) {
             if (m_history.can_undo()) {
                 m_history.undo(graph);
                 m_positioned_nodes.clear();
                 rebuild_links_from_graph();
-                m_generator.evaluate();
+                request_evaluation();
             }
         }
         // Save (check Shift+S before S so exact modifier match fires correctly)
@@ -200,6 +259,8 @@ void editor::draw() {
         draw_node_editor_style_editor();
 
     draw_history_panel();
+    draw_profiler_panel();
+    draw_preview_panel();
     draw_unsaved_modal();
 
 
@@ -259,7 +320,6 @@ void editor::draw_node_editor() {
     ed::SetCurrentEditor(m_node_editor_context);
     ed::Begin("Level Synth", ImVec2(0.0, 0.0f));
 
-    auto& eng = m_generator.engine();
     auto& graph = m_generator.graph();
     // Sync canvas positions back to node data (keeps snapshots accurate).
     for (int nid : m_positioned_nodes) {
@@ -285,17 +345,17 @@ void editor::draw_node_editor() {
     };
 
     if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-        m_drag_before_json      = capture_positions();
-        m_drag_before_full_json = graph.save();
+        m_drag_before_json = capture_positions();
+        m_drag_capture.begin(graph);
     }
     if (ImGui::IsMouseReleased(ImGuiMouseButton_Left) && !m_drag_before_json.empty()) {
         std::string after_pos = capture_positions();
         if (after_pos != m_drag_before_json) {
-            std::string after_full = graph.save();
-            m_history.push({ "Move Nodes", m_drag_before_full_json, after_full });
+            if (auto cmd = m_drag_capture.finish("Move Nodes", graph, m_history.snapshots()))
+                m_history.push(std::move(*cmd));
         }
         m_drag_before_json.clear();
-        m_drag_before_full_json.clear();
+        m_drag_capture.reset();
     }
 
     ed::NodeBuilder builder;
@@ -316,6 +376,12 @@ void editor::draw_node_editor() {
         const auto* entry = reg.find(*n);
         assert(entry && "Node registry entry not found for node");
         ImVec4 header_color = category_color(entry->category);
+        const eval_profile::entry* stats = m_show_node_stats ? m_profile.find(node_id) : nullptr;
+        if (stats && m_profile.max_mean_us() > 0) {
+            // Squared, so only the costliest nodes stand out.
+            const float heat = static_cast<float>(stats->mean_us() / m_profile.max_mean_us());
+            header_color = ImLerp(header_color, ImVec4(0.86f, 0.24f, 0.14f, header_color.w), heat * heat * 0.85f);
+        }
 
         if (m_positioned_nodes.count(node_id) == 0) {
             auto p = n->position();
@@ -378,6 +444,9 @@ void editor::draw_node_editor() {
             }
             builder.EndColumns();
 
+            if (stats)
+                ImGui::TextDisabled("%s", format_node_stats(*stats).c_str());
+
             // Grid preview — only on sink nodes (all pins are inputs, e.g. Output Grid)
             const bool is_sink = std::none_of(desc.pins.begin(), desc.pins.end(),
                 [](const ls::pin_descriptor& p){ return p.direction == ls::pin_direction::output; });
@@ -385,44 +454,28 @@ void editor::draw_node_editor() {
             if (is_sink) {
                 for (const auto& pin : desc.pins) {
                     if (pin.type != ls::pin_type::grid) continue;
-                    const auto* val = eng.get_output(node_id, pin.name);
+                    const auto* val = m_result ? m_result->get_output(node_id, pin.name) : nullptr;
                     if (!val || !std::holds_alternative<std::shared_ptr<ls::grid>>(*val))
                         continue;
                     const auto& g = std::get<std::shared_ptr<ls::grid>>(*val);
                     if (!g || g->width() == 0 || g->height() == 0) continue;
 
                     const float k_preview_w = 150.0f * m_ui_scale;
-                    const float cell      = k_preview_w / static_cast<float>(g->width());
-                    const float preview_h = cell * static_cast<float>(g->height());
-
-                    int min_v = g->get(0, 0).value(), max_v = g->get(0, 0).value();
-                    for (int py = 0; py < g->height(); py++)
-                        for (int px = 0; px < g->width(); px++) {
-                            int cv = g->get(px, py).value();
-                            min_v = std::min(min_v, cv);
-                            max_v = std::max(max_v, cv);
-                        }
-                    const int range = std::max(1, max_v - min_v);
-
-                    ImVec2 origin = ImGui::GetCursorScreenPos();
-                    ImDrawList* dl = ImGui::GetWindowDrawList();
-                    for (int py = 0; py < g->height(); py++) {
-                        for (int px = 0; px < g->width(); px++) {
-                            float t = static_cast<float>(g->get(px, py).value() - min_v)
-                                      / static_cast<float>(range);
-                            int v = static_cast<int>(t * 210 + 20);
-                            ImVec2 p0(origin.x + px * cell,  origin.y + py * cell);
-                            ImVec2 p1(p0.x + cell + 0.5f,   p0.y + cell + 0.5f);
-                            dl->AddRectFilled(p0, p1, IM_COL32(v, v, v, 255));
-                        }
-                    }
-                    ImGui::Dummy(ImVec2(k_preview_w, preview_h));
+                    const float preview_h = k_preview_w * static_cast<float>(g->height())
+                                          / static_cast<float>(g->width());
+
+                    // Uploaded once per new grid; redrawing is a single quad.
+                    if (SDL_Texture* tex = m_grid_textures.get(node_id, pin.name, g))
+                        ImGui::Image((ImTextureID)(intptr_t)tex, ImVec2(k_preview_w, preview_h));
+                    else
+                        ImGui::Dummy(ImVec2(k_preview_w, preview_h));
                     break;
                 }
             }
         }
         builder.End();
     }
+    m_grid_textures.collect();   // previews of deleted nodes
 
     // --- Render links from side map ---
     for (const auto& [link_id, wv] : m_link_to_wire) {
@@ -546,24 +599,34 @@ void editor::draw_node_editor() {
         ImGui::TextUnformatted("Add Node");
         ImGui::Separator();
 
-        auto types = reg.entries();
+        // Registered types plus those of plugins that aren't loaded yet;
+        // picking one of the latter loads its plugin through the registry.
+        const auto pending = m_plugins.pending_types();
 
-        std::map<std::string, std::vector<const ls::node_registration*>> by_category;
-        for (const auto& type : types)
-            by_category[type.second.category].push_back(&type.second);
+        struct menu_type { const std::string* type_name; const std::string* display_name; };
+        std::map<std::string, std::vector<menu_type>> by_category;
+        for (const auto& [_, type] : reg.entries())
+            by_category[type.category].push_back({ &type.type_name, &type.display_name });
+        for (const auto& type : pending)
+            by_category[type.category].push_back({ &type.type_name, &type.display_name });
 
         for (auto& [category, cat_types] : by_category) {
             std::sort(cat_types.begin(), cat_types.end(), [](const auto& a, const auto& b) {
-                return a->display_name < b->display_name;
+                return *a.display_name < *b.display_name;
             });
 
             if (ImGui::BeginMenu(category.c_str())) {
                 for (const auto& type : cat_types) {
-                    if (ImGui::MenuItem(type->display_name.c_str())) {
-                        begin_edit("Add " + type->display_name);
-                        auto node = reg.create(type->type_name);
-                        node->set_position({ m_popup_canvas_pos.x, m_popup_canvas_pos.y });
-                        graph.add_node(std::move(node));
+                    if (ImGui::MenuItem(type.display_name->c_str())) {
+                        const std::string type_name = *type.type_name;
+                        begin_edit("Add " + *type.display_name);
+                        try {
+                            auto node = reg.create(type_name);
+                            node->set_position({ m_popup_canvas_pos.x, m_popup_canvas_pos.y });
+                            graph.add_node(std::move(node));
+                        } catch (const std::exception& e) {
+                            pfd::message("Add node failed", e.what(), pfd::choice::ok, pfd::icon::error);
+                        }
                         commit_edit();
                         rebuild_links_from_graph();
                     }
@@ -618,13 +681,13 @@ void editor::draw_menu_bar() {
             m_history.undo(graph);
             m_positioned_nodes.clear();
             rebuild_links_from_graph();
-            m_generator.evaluate();
+            request_evaluation();
         }
         if (ImGui::MenuItem(ph(phosphor::PH_ARROW_CLOCKWISE, "Redo"), "Cmd+Shift+Z", false, m_history.can_redo())) {
             m_history.redo(graph);
             m_positioned_nodes.clear();
             rebuild_links_from_graph();
-            m_generator.evaluate();
+            request_evaluation();
         }
         ImGui::Separator();
         ed::SetCurrentEditor(m_node_editor_context);
@@ -648,6 +711,18 @@ void editor::draw_menu_bar() {
             m_show_history_panel = !m_show_history_panel;
             save_preferences();
         }
+        if (ImGui::MenuItem(ph(phosphor::PH_GAUGE, "Profiler"), nullptr, m_show_profiler_panel)) {
+            m_show_profiler_panel = !m_show_profiler_panel;
+            save_preferences();
+        }
+        if (ImGui::MenuItem(ph(phosphor::PH_TIMER, "Node Stats"), nullptr, m_show_node_stats)) {
+            m_show_node_stats = !m_show_node_stats;
+            save_preferences();
+        }
+        if (ImGui::MenuItem(ph(phosphor::PH_MAP_TRIFOLD, "Preview"), nullptr, m_show_preview_panel)) {
+            m_show_preview_panel = !m_show_preview_panel;
+            save_preferences();
+        }
         if (ImGui::MenuItem(ph(phosphor::PH_PALETTE, "Node Editor Style"), nullptr, m_show_node_editor_style_window))
             m_show_node_editor_style_window = !m_show_node_editor_style_window;
         if (ImGui::MenuItem(ph(phosphor::PH_ROWS, "Status Bar"), nullptr, m_show_status_bar))
@@ -718,7 +793,7 @@ void editor::draw_menu_bar() {
     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Global generation seed");
 
     if (ImGui::MenuItem(phosphor::PH_PLAY))
-        m_generator.evaluate();
+        request_evaluation();
     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Evaluate graph");
 
     ImGui::EndMainMenuBar();
@@ -795,6 +870,8 @@ void editor::new_graph() {
     m_positioned_nodes.clear();
     m_next_link_id = 1;
     m_current_file.clear();
+    m_profile.clear();
+    request_evaluation();
 }
 
 void editor::load_graph() {
@@ -826,10 +903,11 @@ void editor::load_graph(const std::filesystem::path& path) {
 
         m_history.clear();
         m_positioned_nodes.clear();
+        m_profile.clear();
         rebuild_links_from_graph();
 
         m_current_file = path;
-        m_generator.evaluate();
+        request_evaluation();
         push_recent_file(path);
     } catch (const std::exception& e) {
         pfd::message("Open failed",
@@ -856,7 +934,12 @@ void editor::load_preferences() {
         if      (mode == "light") m_theme_mode = theme_mode::light;
         else if (mode == "dark")  m_theme_mode = theme_mode::dark;
         else                      m_theme_mode = theme_mode::system;
-        m_show_history_panel = j.value("show_history_panel", true);
+        m_show_history_panel  = j.value("show_history_panel", true);
+        m_show_profiler_panel = j.value("show_profiler_panel", true);
+        m_show_node_stats     = j.value("show_node_stats", true);
+        m_show_preview_panel  = j.value("show_preview_panel", true);
+        m_history.set_memory_limit(size_t(j.value("history_memory_mb",
+            int(command_history::k_default_memory_limit >> 20))) << 20);
         for (const auto& p : j.value("recent_files", nlohmann::json::array()))
             m_recent_files.push_back(p.get<std::string>());
     } catch (...) {}
@@ -867,9 +950,13 @@ void editor::save_preferences() {
     const char* mode = "system";
     if      (m_theme_mode == theme_mode::light) mode = "light";
     else if (m_theme_mode == theme_mode::dark)  mode = "dark";
-    j["theme"]              = mode;
-    j["show_history_panel"] = m_show_history_panel;
-    j["recent_files"]       = m_recent_files;
+    j["theme"]               = mode;
+    j["show_history_panel"]  = m_show_history_panel;
+    j["show_profiler_panel"] = m_show_profiler_panel;
+    j["show_node_stats"]     = m_show_node_stats;
+    j["show_preview_panel"]  = m_show_preview_panel;
+    j["history_memory_mb"]   = int(m_history.memory_limit() >> 20);
+    j["recent_files"]        = m_recent_files;
     std::ofstream f(m_pref_dir + "preferences.json");
     if (f) f << j.dump(2);
 }
@@ -885,15 +972,167 @@ void editor::push_recent_file(const std::filesystem::path& path) {
 
 void editor::begin_edit(std::string description) {
     m_edit_description = std::move(description);
-    m_edit_before_json = m_generator.graph().save();
+    m_edit_capture.begin(m_generator.graph());
 }
 
 void editor::commit_edit() {
-    std::string after = m_generator.graph().save();
-    m_history.push({ m_edit_description, m_edit_before_json, after });
+    if (auto cmd = m_edit_capture.finish(m_edit_description, m_generator.graph(),
+                                         m_history.snapshots()))
+        m_history.push(std::move(*cmd));
     m_drag_before_json.clear();
-    m_drag_before_full_json.clear();
-    m_generator.evaluate();
+    m_drag_capture.reset();
+    request_evaluation();
+}
+
+void editor::draw_preview_panel() {
+    if (!m_show_preview_panel) return;
+
+    ImGui::SetNextWindowSize(ImVec2(420 * m_ui_scale, 420 * m_ui_scale), ImGuiCond_FirstUseEver);
+    ImGuiWindow* preview_win = ImGui::FindWindowByName("Preview");
+    bool* preview_open = (preview_win && preview_win->DockNode != nullptr) ? nullptr : &m_show_preview_panel;
+    if (!ImGui::Begin(ph_win(phosphor::PH_MAP_TRIFOLD, "Preview"), preview_open)) {
+        ImGui::End();
+        return;
+    }
+
+    auto& graph = m_generator.graph();
+    auto grid_of = [&](int node_id, const std::string& pin) -> std::shared_ptr<ls::grid> {
+        const auto* val = m_result ? m_result->get_output(node_id, pin) : nullptr;
+        const auto* g = val ? std::get_if<std::shared_ptr<ls::grid>>(val) : nullptr;
+        return g ? *g : nullptr;
+    };
+
+    // Follow a single selected node: its first grid output, or for sinks
+    // the grid they received.
+    ed::SetCurrentEditor(m_node_editor_context);
+    ed::NodeId selected;
+    const bool single = ed::GetSelectedObjectCount() == 1 && ed::GetSelectedNodes(&selected, 1) == 1;
+    ed::SetCurrentEditor(nullptr);
+    if (single) {
+        const int nid = static_cast<int>(selected.Get() & ~k_node_tag);
+        if (const auto* n = graph.find_node(nid)) {
+            for (const auto& pin : n->descriptor().pins) {
+                if (pin.type == ls::pin_type::grid && grid_of(nid, pin.name)) {
+                    m_preview_node = nid;
+                    m_preview_pin = pin.name;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::string label;
+    if (const auto* n = graph.find_node(m_preview_node)) {
+        if (const auto* entry = ls::node_registry::instance().find(*n))
+            label = entry->display_name + " / " + m_preview_pin;
+    }
+    m_grid_viewer.show(label.empty() ? nullptr : grid_of(m_preview_node, m_preview_pin), label);
+    m_grid_viewer.draw(graph.tags(), m_ui_scale);
+
+    ImGui::End();
+}
+
+void editor::draw_profiler_panel() {
+    if (!m_show_profiler_panel) return;
+
+    // First shown as a tab beside the history panel.
+    ImGuiWindow* history_win = ImGui::FindWindowByName("History");
+    if (history_win && history_win->DockId)
+        ImGui::SetNextWindowDockID(history_win->DockId, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(360 * m_ui_scale, 360 * m_ui_scale), ImGuiCond_FirstUseEver);
+    ImGuiWindow* profiler_win = ImGui::FindWindowByName("Profiler");
+    bool* profiler_open = (profiler_win && profiler_win->DockNode != nullptr) ? nullptr : &m_show_profiler_panel;
+    if (!ImGui::Begin(ph_win(phosphor::PH_GAUGE, "Profiler"), profiler_open)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::TextDisabled("Last %zu evaluations", m_profile.evaluations());
+
+    struct row {
+        int id;
+        std::string name;
+        const eval_profile::entry* e;
+    };
+    auto& graph = m_generator.graph();
+    std::vector<row> rows;
+    for (const auto& [id, e] : m_profile.entries()) {
+        const auto* n = graph.find_node(id);
+        if (!n) continue;
+        std::string name = n->name();
+        if (name.empty())
+            if (const auto* entry = ls::node_registry::instance().find(*n))
+                name = entry->display_name + " #" + std::to_string(id);
+        rows.push_back({ id, std::move(name), &e });
+    }
+
+    enum column { col_node, col_last, col_mean, col_max, col_total, col_hits, col_output, col_count };
+    const ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_RowBg |
+        ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("##profile", col_count, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Node",   ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Last",   ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Mean",   ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Max",    ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Total",  ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending |
+                                          ImGuiTableColumnFlags_DefaultSort);
+        ImGui::TableSetupColumn("Hits",   ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Output", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableHeadersRow();
+
+        // A handful of nodes, so sorting every frame is cheaper than
+        // tracking whether the specs changed.
+        if (const ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs && specs->SpecsCount > 0) {
+            const auto& spec = specs->Specs[0];
+            auto key = [&](const row& r) -> double {
+                switch (spec.ColumnIndex) {
+                    case col_last:   return r.e->last.us;
+                    case col_mean:   return r.e->mean_us();
+                    case col_max:    return r.e->max_us;
+                    case col_total:  return r.e->total_us;
+                    case col_hits:   return r.e->samples ? double(r.e->hits) / r.e->samples : 0;
+                    case col_output: return double(r.e->last.output_bytes);
+                    default:         return 0;
+                }
+            };
+            const bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+            std::stable_sort(rows.begin(), rows.end(), [&](const row& a, const row& b) {
+                if (spec.ColumnIndex == col_node)
+                    return ascending ? a.name < b.name : b.name < a.name;
+                return ascending ? key(a) < key(b) : key(b) < key(a);
+            });
+        }
+
+        for (const auto& r : rows) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::PushID(r.id);
+            // Clicking a row selects the node and brings it into view.
+            if (ImGui::Selectable(r.name.c_str(), false, ImGuiSelectableFlags_SpanAllColumns)) {
+                ed::SetCurrentEditor(m_node_editor_context);
+                ed::SelectNode(make_node_id(r.id));
+                ed::NavigateToSelection();
+                ed::SetCurrentEditor(nullptr);
+            }
+            ImGui::PopID();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(r.e->last.us > 0 ? format_us(r.e->last.us).c_str() : "-");
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(r.e->runs ? format_us(r.e->mean_us()).c_str() : "-");
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(r.e->runs ? format_us(r.e->max_us).c_str() : "-");
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(format_us(r.e->total_us).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%d/%d", r.e->hits, r.e->samples);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(r.e->last.output_bytes ? format_bytes(r.e->last.output_bytes).c_str() : "-");
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
 }
 
 void editor::draw_history_panel() {
@@ -911,12 +1150,7 @@ void editor::draw_history_panel() {
     const int  cur   = m_history.pos();
     const int  saved = m_history.saved_pos();
 
-    // Compute total raw memory (each entry stores two strings)
-    size_t total_bytes = 0;
-    for (int i = 0; i < n; ++i) {
-        const auto& e = m_history.entry(i);
-        total_bytes += e.before_json.size() + e.after_json.size();
-    }
+    const size_t total_bytes = m_history.bytes();
 
     // "Initial state" row
     if (cur == 0)
@@ -930,7 +1164,7 @@ void editor::draw_history_panel() {
         const bool is_redo  = (i >= cur);
         const bool is_saved = (i == saved - 1);
 
-        float kb = static_cast<float>(e.after_json.size()) / 1024.0f;
+        float kb = static_cast<float>(e.bytes()) / 1024.0f;
         const char* saved_marker = is_saved ? " [saved]" : "";
 
         if (is_redo)
@@ -948,7 +1182,7 @@ void editor::draw_history_panel() {
 
     ImGui::Separator();
     float total_kb = static_cast<float>(total_bytes) / 1024.0f;
-    ImGui::TextDisabled("%d snapshots  |  %.1f KB total", n, total_kb);
+    ImGui::TextDisabled("%d entries  |  %.1f KB total", n, total_kb);
 
     ImGui::End();
 }
@@ -1370,7 +1604,7 @@ void editor::draw_details_panel() {
                 commit_edit();
 
             if (vis.changed)
-                m_generator.evaluate();
+                request_evaluation();
         }
     } else if (node_count == 0) {
         ImGui::TextDisabled("No node selected");
@@ -1402,6 +1636,15 @@ void editor::draw_status_bar() {
                 ImGui::Text("%d nodes  %s  %d wires", n, "\xc2\xb7", w);
             }
 
+            if (m_evaluator.busy()) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("%s  Evaluating...", "\xc2\xb7");
+            } else if (m_result && !m_result->error.empty()) {
+                ImGui::SameLine();
+                ImGui::TextColored(ImVec4(0.9f, 0.35f, 0.3f, 1.0f), "%s  %s", "\xc2\xb7",
+                                   m_result->error.c_str());
+            }
+
             char fps_buf[32];
             snprintf(fps_buf, sizeof(fps_buf), "%.0f fps", ImGui::GetIO().Framerate);
             float fps_w = ImGui::CalcTextSize(fps_buf).x;
@@ -5,7 +5,9 @@
 #include <level_synth/generator.hpp>
 #include <level_synth/node.hpp>
 #include <level_synth/pin.hpp>
+#include <level_synth/plugin_loader.hpp>
 #include <filesystem>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
@@ -14,13 +16,17 @@
 #include "tag_panel.hpp"
 #include "nodes/node_colors.hpp"
 #include "command_history.hpp"
+#include "background_evaluator.hpp"
+#include "grid_texture_cache.hpp"
+#include "grid_viewer.hpp"
+#include "eval_profile.hpp"
 
 class editor {
 public:
-    editor() = default;
+    editor();
     ~editor();
 
-    void init(const std::string& pref_dir, float ui_scale);
+    void init(const std::string& pref_dir, float ui_scale, SDL_Renderer* renderer);
     void draw();
 
     /// Returns the string that should appear in the OS window title bar.
@@ -79,12 +85,32 @@ private:
     void commit_edit();
 
     void draw_history_panel();
+    void draw_preview_panel();
+    void draw_profiler_panel();
+
+    // Evaluate the current graph on the background worker. Previews keep
+    // showing the last result until the new one arrives.
+    void request_evaluation();
 
     float m_ui_scale = 1.0f;
 
     ax::NodeEditor::EditorContext* m_node_editor_context = nullptr;
+    ls::plugin_loader m_plugins;
     ls::generator m_generator;
     command_history m_history;
+    background_evaluator m_evaluator;
+    // What previews show this frame; taken from m_evaluator once per draw().
+    std::shared_ptr<const background_evaluator::result> m_result;
+    grid_texture_cache m_grid_textures;
+    grid_viewer m_grid_viewer;
+    // Grid the preview panel shows; follows the selection, and stays put
+    // while nothing with a grid is selected.
+    int m_preview_node = 0;
+    std::string m_preview_pin;
+    // Engine stats of the last few results, for node overlays and the
+    // profiler panel.
+    eval_profile m_profile;
+    uint64_t m_profiled_generation = 0;
     ls::tag_panel tag_panel;
 
     struct wire_visual {
@@ -102,12 +128,12 @@ private:
 
     // Pending edit state for begin_edit / commit_edit
     std::string m_edit_description;
-    std::string m_edit_before_json;
+    edit_capture m_edit_capture;
     // Before-state captured on mouse press for node drag detection.
     // m_drag_before_json holds positions-only JSON for change detection.
-    // m_drag_before_full_json holds the full graph snapshot for the undo before-state.
+    // m_drag_capture holds the graph state the undo delta is computed from.
     std::string m_drag_before_json;
-    std::string m_drag_before_full_json;
+    edit_capture m_drag_capture;
 
     enum class theme_mode { system, light, dark };
 
@@ -116,6 +142,9 @@ private:
     bool m_dark_theme = true;  // resolved cache; m_theme_mode is the source of truth
     bool m_show_demo_window   = false;
     bool m_show_history_panel = true;
+    bool m_show_preview_panel = true;
+    bool m_show_profiler_panel = true;
+    bool m_show_node_stats = true;      // timing/memory line and heat tint on nodes
     bool m_show_details_panel    = true;
     bool m_show_node_editor_style_window = false;
     bool m_show_status_bar = true;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+
+#include <level_synth/eval_engine.hpp>
+
+// ---------------------------------------------------------------------------
+// eval_profile — per-node engine stats over the last few evaluations
+//
+// Fed one eval_engine::last_node_stats() map per finished evaluation. A
+// node's cost is what the engine measured whenever it actually ran;
+// evaluations that reused its outputs count as cache hits and add no time.
+// Keyed by node id, so it should be cleared when the graph is replaced.
+// ---------------------------------------------------------------------------
+
+class eval_profile {
+public:
+    using node_stats = ls::eval_engine::node_stats;
+
+    static constexpr size_t k_window = 16;     // evaluations kept
+
+    struct entry {
+        node_stats last;            // from the newest evaluation
+        double total_us = 0;        // over the window
+        double max_us = 0;
+        int runs = 0;               // evaluations that ran the node
+        int hits = 0;               // evaluations that reused or merged its outputs
+        int samples = 0;            // evaluations that saw the node
+
+        double mean_us() const { return runs ? total_us / runs : 0; }
+    };
+
+    void add(const std::unordered_map<int, node_stats>& stats) {
+        m_window.push_back(stats);
+        if (m_window.size() > k_window) m_window.pop_front();
+        rebuild();
+    }
+
+    void clear() {
+        m_window.clear();
+        m_entries.clear();
+        m_max_mean_us = 0;
+    }
+
+    size_t evaluations() const { return m_window.size(); }
+    const std::unordered_map<int, entry>& entries() const { return m_entries; }
+
+    const entry* find(int node_id) const {
+        auto it = m_entries.find(node_id);
+        return it != m_entries.end() ? &it->second : nullptr;
+    }
+
+    // Largest entry::mean_us(), for scaling heatmaps.
+    double max_mean_us() const { return m_max_mean_us; }
+
+private:
+    void rebuild() {
+        m_entries.clear();
+        for (const auto& stats : m_window) {
+            for (const auto& [id, s] : stats) {
+                auto& e = m_entries[id];
+                e.last = s;
+                ++e.samples;
+                switch (s.result) {
+                    case node_stats::outcome::reused:
+                    case node_stats::outcome::merged:
+                        ++e.hits;
+                        break;
+                    case node_stats::outcome::evaluated:
+                    case node_stats::outcome::failed:
+                        ++e.runs;
+                        e.total_us += s.us;
+                        e.max_us = std::max(e.max_us, s.us);
+                        break;
+                    case node_stats::outcome::fused:
+                        break;
+                }
+            }
+        }
+        // Nodes missing from the newest evaluation are gone from the graph.
+        std::erase_if(m_entries, [&](const auto& kv) { return !m_window.back().count(kv.first); });
+        m_max_mean_us = 0;
+        for (const auto& [id, e] : m_entries)
+            m_max_mean_us = std::max(m_max_mean_us, e.mean_us());
+    }
+
+    std::deque<std::unordered_map<int, node_stats>> m_window;
+    std::unordered_map<int, entry> m_entries;
+    double m_max_mean_us = 0;
+};
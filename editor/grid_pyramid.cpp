@@ -0,0 +1,89 @@
+#include "grid_pyramid.hpp"
+
+#include <algorithm>
+
+namespace {
+
+ls::tag dominant(const ls::tag* cells, int n) {
+    int best = 0, best_count = 0;
+    for (int i = 0; i < n; ++i) {
+        int count = 0;
+        for (int j = i; j < n; ++j)
+            count += cells[j] == cells[i];
+        if (count > best_count) {
+            best = i;
+            best_count = count;
+        }
+    }
+    return cells[best];
+}
+
+ls::tag extreme(const ls::tag* cells, int n, bool want_max) {
+    const ls::tag* pick = nullptr;
+    for (int i = 0; i < n; ++i) {
+        if (cells[i].type() != ls::tag_type::numeric) continue;
+        if (!pick || (want_max ? cells[i].value() > pick->value()
+                               : cells[i].value() < pick->value()))
+            pick = &cells[i];
+    }
+    return pick ? *pick : dominant(cells, n);
+}
+
+} // anonymous namespace
+
+std::shared_ptr<const grid_pyramid> grid_pyramid::build(std::shared_ptr<const ls::grid> source,
+                                                        reduce mode, const ls::cancel_token& cancel,
+                                                        int min_size) {
+    auto p = std::make_shared<grid_pyramid>();
+    p->m_mode = mode;
+
+    bool numeric = false;
+    for (int y = 0; y < source->height(); ++y) {
+        if (cancel.cancelled()) return nullptr;
+        const ls::tag* row = source->data() + size_t(y) * source->width();
+        for (int x = 0; x < source->width(); ++x) {
+            if (row[x].type() != ls::tag_type::numeric) continue;
+            const int64_t v = row[x].value();
+            p->m_min = numeric ? std::min(p->m_min, v) : v;
+            p->m_max = numeric ? std::max(p->m_max, v) : v;
+            numeric = true;
+        }
+    }
+
+    p->m_levels.push_back(std::move(source));
+    while (std::max(p->m_levels.back()->width(), p->m_levels.back()->height()) > min_size) {
+        auto next = halve(*p->m_levels.back(), mode, cancel);
+        if (!next) return nullptr;
+        p->m_levels.push_back(std::move(next));
+    }
+    return p;
+}
+
+std::unique_ptr<ls::grid> grid_pyramid::halve(const ls::grid& g, reduce mode, const ls::cancel_token& cancel) {
+    const int w = (g.width() + 1) / 2;
+    const int h = (g.height() + 1) / 2;
+    auto out = std::make_unique<ls::grid>(w, h);
+    ls::tag* dst = out->mutable_data();
+
+    for (int y = 0; y < h; ++y) {
+        if (cancel.cancelled()) return nullptr;
+        const int sy = y * 2;
+        const int rows = std::min(2, g.height() - sy);
+        for (int x = 0; x < w; ++x) {
+            const int sx = x * 2;
+            const int cols = std::min(2, g.width() - sx);
+            ls::tag block[4];
+            int n = 0;
+            for (int dy = 0; dy < rows; ++dy)
+                for (int dx = 0; dx < cols; ++dx)
+                    block[n++] = g.get(sx + dx, sy + dy);
+
+            switch (mode) {
+                case reduce::dominant: dst[y * w + x] = dominant(block, n);       break;
+                case reduce::min:      dst[y * w + x] = extreme(block, n, false); break;
+                case reduce::max:      dst[y * w + x] = extreme(block, n, true);  break;
+            }
+        }
+    }
+    return out;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <level_synth/cancel_token.hpp>
+#include <level_synth/grid.hpp>
+
+// ---------------------------------------------------------------------------
+// grid_pyramid — a grid and successively halved copies of it
+//
+// Level 0 is the source grid; each further level has one cell per 2x2 block
+// of the level before, down to the first level that fits in `min_size`
+// cells each way. Viewers draw the level nearest one cell per pixel, so a
+// zoomed-out 4096x4096 grid costs about as much as a screenful.
+//
+// How a block collapses is the reduce mode:
+//   dominant — the most frequent tag in the block (ties: the first in row
+//              order), for symbolic maps where averaging means nothing
+//   min, max — the smallest / largest numeric value; blocks without
+//              numeric cells fall back to dominant
+//
+// Building touches every cell once per level, so it's meant to run off the
+// UI thread; build() polls `cancel` between rows.
+// ---------------------------------------------------------------------------
+class grid_pyramid {
+public:
+    enum class reduce { dominant, min, max };
+
+    // Null if `cancel` fired before the pyramid was complete.
+    static std::shared_ptr<const grid_pyramid> build(std::shared_ptr<const ls::grid> source,
+                                                     reduce mode, const ls::cancel_token& cancel,
+                                                     int min_size = 256);
+
+    int levels() const { return static_cast<int>(m_levels.size()); }
+    const ls::grid& level(int i) const { return *m_levels[i]; }
+    const std::shared_ptr<const ls::grid>& source() const { return m_levels[0]; }
+    reduce mode() const { return m_mode; }
+
+    // Range of the source's numeric cells, both 0 if it has none. Found by
+    // build() rather than grid::stats(), whose full scan can't be cancelled.
+    int64_t min_value() const { return m_min; }
+    int64_t max_value() const { return m_max; }
+
+private:
+    // Next level down from `g`, or null if cancelled.
+    static std::unique_ptr<ls::grid> halve(const ls::grid& g, reduce mode, const ls::cancel_token& cancel);
+
+    std::vector<std::shared_ptr<const ls::grid>> m_levels;
+    reduce m_mode = reduce::dominant;
+    int64_t m_min = 0;
+    int64_t m_max = 0;
+};
@@ -0,0 +1,83 @@
+#include "grid_texture_cache.hpp"
+
+#include <algorithm>
+
+SDL_Texture* grid_texture_cache::get(int node_id, const std::string& pin,
+                                     const std::shared_ptr<ls::grid>& g) {
+    if (!m_renderer || !g || g->width() == 0 || g->height() == 0) return nullptr;
+
+    auto& e = m_entries[{ node_id, pin }];
+    e.used = true;
+    if (e.source == g && e.texture) return e.texture;
+
+    int max_size = static_cast<int>(SDL_GetNumberProperty(
+        SDL_GetRendererProperties(m_renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 0));
+    if (max_size <= 0) max_size = 4096;
+    const int step = (std::max(g->width(), g->height()) + max_size - 1) / max_size;
+    const int w = (g->width() + step - 1) / step;
+    const int h = (g->height() + step - 1) / step;
+
+    // Same-sized results (the usual case while tweaking a parameter)
+    // reuse the texture and only upload new pixels.
+    if (e.texture && (e.width != w || e.height != h)) {
+        SDL_DestroyTexture(e.texture);
+        e.texture = nullptr;
+    }
+    if (!e.texture) {
+        e.texture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA32,
+                                      SDL_TEXTUREACCESS_STATIC, w, h);
+        if (!e.texture) {
+            e.source.reset();
+            return nullptr;
+        }
+        SDL_SetTextureScaleMode(e.texture, SDL_SCALEMODE_NEAREST);
+        e.width = w;
+        e.height = h;
+    }
+
+    to_rgba(*g, step, w, h, m_pixels);
+    SDL_UpdateTexture(e.texture, nullptr, m_pixels.data(), w * 4);
+    e.source = g;
+    return e.texture;
+}
+
+void grid_texture_cache::collect() {
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.used) {
+            it->second.used = false;
+            ++it;
+        } else {
+            if (it->second.texture) SDL_DestroyTexture(it->second.texture);
+            it = m_entries.erase(it);
+        }
+    }
+}
+
+void grid_texture_cache::clear() {
+    for (auto& [key, e] : m_entries)
+        if (e.texture) SDL_DestroyTexture(e.texture);
+    m_entries.clear();
+}
+
+void grid_texture_cache::to_rgba(const ls::grid& g, int step, int w, int h, std::vector<uint8_t>& out) {
+    // Grey ramp over the grid's numeric range. Cached on the grid, so the
+    // stats cost one scan per evaluation at most.
+    const auto& stats = g.stats();
+    const int64_t min_v = stats.min_value;
+    const float range = static_cast<float>(std::max<int64_t>(1, stats.max_value - stats.min_value));
+
+    out.resize(size_t(w) * h * 4);
+    uint8_t* p = out.data();
+    for (int y = 0; y < h; ++y) {
+        const ls::tag* row = g.data() + size_t(y) * step * g.width();
+        for (int x = 0; x < w; ++x, p += 4) {
+            float t = static_cast<float>(row[x * step].value() - min_v) / range;
+            t = std::clamp(t, 0.0f, 1.0f);
+            const auto v = static_cast<uint8_t>(t * 210 + 20);
+            p[0] = v;
+            p[1] = v;
+            p[2] = v;
+            p[3] = 255;
+        }
+    }
+}
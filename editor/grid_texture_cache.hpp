@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <level_synth/grid.hpp>
+
+// ---------------------------------------------------------------------------
+// grid_texture_cache — grid previews as GPU textures
+//
+// Each (node, pin) preview owns one texture holding the grid as RGBA, one
+// texel per cell, sampled nearest-neighbour so cells stay sharp at any
+// zoom. The texture is only rebuilt when the pin's grid object changes;
+// evaluations hand out new grids rather than mutating published ones, so
+// identity is enough to tell.
+//
+// Usage (in editor):
+//   // per preview:
+//   if (SDL_Texture* tex = m_grid_textures.get(node_id, pin, g))
+//       ImGui::Image((ImTextureID)(intptr_t)tex, size);
+//   // once per frame, after drawing:
+//   m_grid_textures.collect();
+// ---------------------------------------------------------------------------
+class grid_texture_cache {
+public:
+    grid_texture_cache() = default;
+    ~grid_texture_cache() { clear(); }
+
+    grid_texture_cache(const grid_texture_cache&) = delete;
+    grid_texture_cache& operator=(const grid_texture_cache&) = delete;
+
+    // Must be set before get(); textures are created on this renderer.
+    void set_renderer(SDL_Renderer* renderer) { m_renderer = renderer; }
+
+    // Texture showing `g` for the preview of `pin` on `node_id`, uploaded
+    // if `g` isn't the grid it was last built from. Grids larger than the
+    // renderer's texture limit are sampled down to fit. Null on failure.
+    SDL_Texture* get(int node_id, const std::string& pin, const std::shared_ptr<ls::grid>& g);
+
+    // Destroy textures that no get() asked for since the last collect(),
+    // e.g. of deleted nodes.
+    void collect();
+
+    void clear();
+
+private:
+    struct entry {
+        std::shared_ptr<ls::grid> source;   // kept so its address can't be reused
+        SDL_Texture* texture = nullptr;
+        int width = 0;
+        int height = 0;
+        bool used = false;
+    };
+
+    // Convert `g` to `out`: w * h RGBA pixels (4 bytes each), sampling
+    // every `step`th cell.
+    static void to_rgba(const ls::grid& g, int step, int w, int h, std::vector<uint8_t>& out);
+
+    SDL_Renderer* m_renderer = nullptr;
+    std::map<std::pair<int, std::string>, entry> m_entries;
+    std::vector<uint8_t> m_pixels;      // scratch, reused across uploads
+};
@@ -0,0 +1,287 @@
+#include "grid_viewer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
+namespace {
+
+// Numeric cells on a grey ramp over the source grid's range; symbolic
+// cells in their tag color (or an ancestor's), else one derived from the
+// tag bits so distinct tags stay distinct.
+class cell_colors {
+public:
+    cell_colors(int64_t min_value, int64_t max_value, const ls::tag_registry& tags)
+        : m_min(min_value),
+          m_range(static_cast<float>(std::max<int64_t>(1, max_value - min_value))),
+          m_tags(tags) {}
+
+    uint32_t operator()(ls::tag t) {
+        if (t.type() == ls::tag_type::numeric) {
+            float v = std::clamp(static_cast<float>(t.value() - m_min) / m_range, 0.0f, 1.0f);
+            const auto g = static_cast<uint32_t>(v * 210 + 20);
+            return IM_COL32(g, g, g, 255);
+        }
+        auto [it, added] = m_symbolic.try_emplace(t.raw());
+        if (added) it->second = resolve(t);
+        return it->second;
+    }
+
+private:
+    uint32_t resolve(ls::tag t) const {
+        const ls::tag chain[] = {
+            t,
+            ls::tag::symbolic(t.l0(), t.l1(), 0),
+            ls::tag::symbolic(t.l0(), 0, 0),
+        };
+        for (const auto& c : chain)
+            if (auto color = m_tags.get_color(c))
+                return *color | IM_COL32(0, 0, 0, 255);
+        uint64_t h = t.raw() * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29;
+        return IM_COL32(70 + (h & 0x7f), 70 + ((h >> 8) & 0x7f), 70 + ((h >> 16) & 0x7f), 255);
+    }
+
+    int64_t m_min;
+    float m_range;
+    const ls::tag_registry& m_tags;
+    std::unordered_map<uint64_t, uint32_t> m_symbolic;
+};
+
+} // anonymous namespace
+
+grid_viewer::~grid_viewer() {
+    m_build_cancel.cancel();
+    retire_build();
+    for (auto& f : m_retired) f.wait();
+    drop_tiles();
+}
+
+void grid_viewer::show(std::shared_ptr<ls::grid> g, std::string label) {
+    m_label = std::move(label);
+    if (g == m_requested) return;
+    m_requested = std::move(g);
+    if (!m_requested) {
+        m_build_cancel.cancel();
+        retire_build();
+        m_pyramid.reset();
+        drop_tiles();
+        return;
+    }
+    start_build();
+}
+
+void grid_viewer::start_build() {
+    m_build_cancel.cancel();
+    m_build_cancel = ls::cancel_token();
+    retire_build();
+    m_building = std::async(std::launch::async,
+        [source = m_requested, mode = m_mode, cancel = m_build_cancel, wake = m_wake] {
+            auto p = grid_pyramid::build(source, mode, cancel, k_tile);
+            if (p && wake) wake();
+            return p;
+        });
+}
+
+void grid_viewer::retire_build() {
+    // Destroying a std::async future waits for its task. The task stops at
+    // its next row once cancelled, but that wait still doesn't belong on the
+    // UI thread, so the future is parked until draw() finds it ready.
+    if (m_building.valid()) m_retired.push_back(std::move(m_building));
+}
+
+void grid_viewer::fit(ImVec2 canvas) {
+    const auto& g = m_pyramid->level(0);
+    m_zoom = std::min(canvas.x / g.width(), canvas.y / g.height());
+    m_offset = ImVec2((g.width() - canvas.x / m_zoom) * 0.5f,
+                      (g.height() - canvas.y / m_zoom) * 0.5f);
+}
+
+void grid_viewer::drop_tiles() {
+    for (auto& [key, t] : m_tiles)
+        if (t.texture) SDL_DestroyTexture(t.texture);
+    m_tiles.clear();
+}
+
+grid_viewer::tile grid_viewer::upload(const ls::grid& level, int tx, int ty, const ls::tag_registry& tags) {
+    tile t;
+    const int x0 = tx * k_tile;
+    const int y0 = ty * k_tile;
+    t.width  = std::min(k_tile, level.width() - x0);
+    t.height = std::min(k_tile, level.height() - y0);
+    t.texture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                  t.width, t.height);
+    if (!t.texture) return t;
+    SDL_SetTextureScaleMode(t.texture, SDL_SCALEMODE_NEAREST);
+
+    cell_colors color(m_pyramid->min_value(), m_pyramid->max_value(), tags);
+    m_pixels.resize(size_t(t.width) * t.height * 4);
+    uint8_t* p = m_pixels.data();
+    for (int y = 0; y < t.height; ++y) {
+        const ls::tag* row = level.data() + size_t(y0 + y) * level.width() + x0;
+        for (int x = 0; x < t.width; ++x, p += 4) {
+            const uint32_t c = color(row[x]);
+            p[0] = uint8_t(c >> IM_COL32_R_SHIFT);
+            p[1] = uint8_t(c >> IM_COL32_G_SHIFT);
+            p[2] = uint8_t(c >> IM_COL32_B_SHIFT);
+            p[3] = uint8_t(c >> IM_COL32_A_SHIFT);
+        }
+    }
+    SDL_UpdateTexture(t.texture, nullptr, m_pixels.data(), t.width * 4);
+    return t;
+}
+
+void grid_viewer::draw(const ls::tag_registry& tags, float ui_scale) {
+    int mode = static_cast<int>(m_mode);
+    ImGui::SetNextItemWidth(110 * ui_scale);
+    if (ImGui::Combo("##reduce", &mode, "Dominant\0Min\0Max\0")) {
+        m_mode = static_cast<grid_pyramid::reduce>(mode);
+        if (m_requested) start_build();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("How zoomed-out cells combine the cells they cover");
+    ImGui::SameLine();
+    if (ImGui::Button("Fit")) m_needs_fit = true;
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", m_label.c_str());
+
+    std::erase_if(m_retired, [](const auto& f) {
+        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    });
+    if (m_building.valid() &&
+        m_building.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        if (auto p = m_building.get()) {
+            const bool resized = !m_pyramid
+                || p->level(0).width()  != m_pyramid->level(0).width()
+                || p->level(0).height() != m_pyramid->level(0).height();
+            drop_tiles();
+            m_pyramid = std::move(p);
+            m_needs_fit |= resized;
+        }
+    }
+
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const ImVec2 size   = ImGui::GetContentRegionAvail();
+    if (size.x < 1 || size.y < 1) return;
+    ImGui::InvisibleButton("##canvas", size,
+        ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonMiddle);
+    const bool hovered = ImGui::IsItemHovered();
+    const bool active  = ImGui::IsItemActive();
+
+    ImDrawList* dl = ImGui::GetWindowDrawList();
+    const ImVec2 end(origin.x + size.x, origin.y + size.y);
+    dl->AddRectFilled(origin, end, IM_COL32(24, 24, 24, 255));
+
+    if (!m_pyramid) {
+        const char* msg = m_requested ? "Building preview..." : "Select a node with a grid output";
+        dl->AddText(ImVec2(origin.x + 8 * ui_scale, origin.y + 8 * ui_scale),
+                    ImGui::GetColorU32(ImGuiCol_TextDisabled), msg);
+        return;
+    }
+    if (m_needs_fit) {
+        fit(size);
+        m_needs_fit = false;
+    }
+
+    // Drag pans; the wheel zooms about the cursor; double-click refits.
+    ImGuiIO& io = ImGui::GetIO();
+    if (active && (ImGui::IsMouseDragging(ImGuiMouseButton_Left, 0.0f) ||
+                   ImGui::IsMouseDragging(ImGuiMouseButton_Middle, 0.0f))) {
+        m_offset.x -= io.MouseDelta.x / m_zoom;
+        m_offset.y -= io.MouseDelta.y / m_zoom;
+    }
+    if (hovered && io.MouseWheel != 0.0f) {
+        const ImVec2 m(io.MousePos.x - origin.x, io.MousePos.y - origin.y);
+        const ImVec2 at(m_offset.x + m.x / m_zoom, m_offset.y + m.y / m_zoom);
+        m_zoom = std::clamp(m_zoom * std::pow(1.2f, io.MouseWheel), 1.0f / 4096.0f, 64.0f);
+        m_offset = ImVec2(at.x - m.x / m_zoom, at.y - m.y / m_zoom);
+    }
+    if (hovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+        fit(size);
+
+    // The level with about one texel per pixel, and under it the coarsest
+    // (a single tile), which covers for tiles not uploaded yet.
+    const int coarsest = m_pyramid->levels() - 1;
+    const int level = std::clamp(static_cast<int>(std::floor(std::log2(1.0f / m_zoom))), 0, coarsest);
+
+    int uploads = 0;
+    bool missing = false;
+    dl->PushClipRect(origin, end, true);
+    const int draw_levels[] = { coarsest, level };
+    for (int i = 0; i < (level == coarsest ? 1 : 2); ++i) {
+        const int lv = draw_levels[i];
+        const auto& g = m_pyramid->level(lv);
+        const float s = static_cast<float>(1 << lv);     // level-0 cells per cell
+        const float x0 = m_offset.x / s, x1 = (m_offset.x + size.x / m_zoom) / s;
+        const float y0 = m_offset.y / s, y1 = (m_offset.y + size.y / m_zoom) / s;
+        const int tx0 = std::max(0, static_cast<int>(std::floor(x0 / k_tile)));
+        const int ty0 = std::max(0, static_cast<int>(std::floor(y0 / k_tile)));
+        const int tx1 = std::min((g.width()  - 1) / k_tile, static_cast<int>(std::floor(x1 / k_tile)));
+        const int ty1 = std::min((g.height() - 1) / k_tile, static_cast<int>(std::floor(y1 / k_tile)));
+
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                auto it = m_tiles.find({ lv, tx, ty });
+                if (it == m_tiles.end()) {
+                    if (uploads == k_uploads_per_frame) { missing = true; continue; }
+                    ++uploads;
+                    it = m_tiles.emplace(tile_key{ lv, tx, ty }, upload(g, tx, ty, tags)).first;
+                }
+                tile& t = it->second;
+                t.used = true;
+                if (!t.texture) continue;
+                const ImVec2 p0(origin.x + (tx * k_tile * s - m_offset.x) * m_zoom,
+                                origin.y + (ty * k_tile * s - m_offset.y) * m_zoom);
+                const ImVec2 p1(p0.x + t.width * s * m_zoom, p0.y + t.height * s * m_zoom);
+                dl->AddImage((ImTextureID)(intptr_t)t.texture, p0, p1);
+            }
+        }
+    }
+
+    // Hover: outline and name the level-0 cell under the cursor.
+    const auto& source = m_pyramid->level(0);
+    if (hovered && !active) {
+        const int cx = static_cast<int>(std::floor(m_offset.x + (io.MousePos.x - origin.x) / m_zoom));
+        const int cy = static_cast<int>(std::floor(m_offset.y + (io.MousePos.y - origin.y) / m_zoom));
+        if (source.in_bounds(cx, cy)) {
+            if (m_zoom >= 4.0f) {
+                const ImVec2 p0(origin.x + (cx - m_offset.x) * m_zoom, origin.y + (cy - m_offset.y) * m_zoom);
+                dl->AddRect(p0, ImVec2(p0.x + m_zoom, p0.y + m_zoom), IM_COL32(255, 210, 0, 255));
+            }
+            const ls::tag t = source.get(cx, cy);
+            ImGui::BeginTooltip();
+            ImGui::Text("%d, %d", cx, cy);
+            if (t.type() == ls::tag_type::numeric) {
+                ImGui::Text("%lld", static_cast<long long>(t.value()));
+            } else if (auto id = tags.identifier(t); !id.empty()) {
+                ImGui::Text("%.*s", static_cast<int>(id.size()), id.data());
+            } else {
+                ImGui::TextDisabled("unregistered tag %016llx", static_cast<unsigned long long>(t.raw()));
+            }
+            ImGui::EndTooltip();
+        }
+    }
+    dl->PopClipRect();
+
+    char info[64];
+    snprintf(info, sizeof(info), "%dx%d  level %d  %.0f%%",
+             source.width(), source.height(), level, m_zoom * 100.0f);
+    dl->AddText(ImVec2(origin.x + 6 * ui_scale, end.y - ImGui::GetFontSize() - 4 * ui_scale),
+                IM_COL32(200, 200, 200, 200), info);
+
+    // Keep off-screen tiles for panning back, up to a cap.
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        if (!it->second.used && m_tiles.size() > k_max_tiles) {
+            if (it->second.texture) SDL_DestroyTexture(it->second.texture);
+            it = m_tiles.erase(it);
+        } else {
+            it->second.used = false;
+            ++it;
+        }
+    }
+
+    // Tiles left over wait for the next frame, which an idle UI wouldn't draw.
+    if (missing && m_wake) m_wake();
+}
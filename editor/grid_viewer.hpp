@@ -0,0 +1,95 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <imgui.h>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <level_synth/cancel_token.hpp>
+#include <level_synth/grid.hpp>
+#include <level_synth/tag_registry.hpp>
+
+#include "grid_pyramid.hpp"
+
+// ---------------------------------------------------------------------------
+// grid_viewer — pan/zoom inspection of grids too big for a thumbnail
+//
+// Draws a grid_pyramid level chosen so a texel is about a screen pixel,
+// cut into square tiles that are uploaded to textures only once they come
+// into view (a few per frame, coarsest level first so something is always
+// on screen). Hovering shows the exact tag of the level-0 cell under the
+// cursor.
+//
+// Pyramids are built on a worker; until a new one is ready the previous
+// grid stays up. A build that is superseded is cancelled and left to
+// finish on its own, so the UI never waits for one.
+//
+// Usage (in editor):
+//   grid_viewer m_viewer{ wake };        // wake: request another frame
+//   m_viewer.set_renderer(renderer);
+//   // in draw(), inside a window:
+//   m_viewer.show(grid, "Output Grid / value");
+//   m_viewer.draw(tags, ui_scale);
+// ---------------------------------------------------------------------------
+class grid_viewer {
+public:
+    // `wake` may run on any thread; it should make the UI draw another frame.
+    explicit grid_viewer(std::function<void()> wake = {}) : m_wake(std::move(wake)) {}
+    ~grid_viewer();
+
+    grid_viewer(const grid_viewer&) = delete;
+    grid_viewer& operator=(const grid_viewer&) = delete;
+
+    void set_renderer(SDL_Renderer* renderer) { m_renderer = renderer; }
+
+    // Grid to display, null for none. A grid other than the last one
+    // starts a pyramid build.
+    void show(std::shared_ptr<ls::grid> g, std::string label);
+
+    // Controls and canvas, filling the rest of the current window.
+    void draw(const ls::tag_registry& tags, float ui_scale);
+
+    static constexpr int k_tile = 256;              // cells per tile side
+    static constexpr int k_uploads_per_frame = 4;
+    static constexpr int k_max_tiles = 128;         // kept while out of view
+
+private:
+    struct tile {
+        SDL_Texture* texture = nullptr;
+        int width = 0;          // cells; edge tiles are smaller than k_tile
+        int height = 0;
+        bool used = false;
+    };
+    using tile_key = std::tuple<int, int, int>;     // level, tile x, tile y
+
+    void start_build();
+    void retire_build();
+    void fit(ImVec2 canvas);
+    void drop_tiles();
+    tile upload(const ls::grid& level, int tx, int ty, const ls::tag_registry& tags);
+
+    std::function<void()> m_wake;
+    SDL_Renderer* m_renderer = nullptr;
+
+    std::shared_ptr<ls::grid> m_requested;          // last grid passed to show()
+    std::string m_label;
+    grid_pyramid::reduce m_mode = grid_pyramid::reduce::dominant;
+    std::future<std::shared_ptr<const grid_pyramid>> m_building;
+    ls::cancel_token m_build_cancel;                // of m_building
+    std::vector<std::future<std::shared_ptr<const grid_pyramid>>> m_retired;   // cancelled, still winding down
+
+    std::shared_ptr<const grid_pyramid> m_pyramid;  // what's on screen
+    std::map<tile_key, tile> m_tiles;               // of m_pyramid
+    std::vector<uint8_t> m_pixels;                  // scratch for uploads
+
+    // View: screen pixels per level-0 cell, and the level-0 cell at the
+    // canvas's top-left corner.
+    float  m_zoom = 1.0f;
+    ImVec2 m_offset = { 0, 0 };
+    bool   m_needs_fit = true;
+};
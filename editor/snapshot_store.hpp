@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <level_synth/lz.hpp>
+
+// ---------------------------------------------------------------------------
+// snapshot_store — interned, compressed node state snapshots
+//
+// Snapshots hold the node::save_state() blobs undo entries keep for what a
+// structural delta can't express. Equal snapshots share one compressed
+// blob, so the "after" of one command and the "before" of the next cost a
+// single copy, and an edit that is undone and redone doesn't add any.
+//
+// Handles are reference counted; a blob lives as long as some command holds
+// it, and the store only keeps weak references for lookup.
+// ---------------------------------------------------------------------------
+
+class snapshot_store {
+public:
+    struct blob {
+        size_t               hash;
+        size_t               raw_size;
+        std::vector<uint8_t> data;      // lz_compress(state)
+
+        size_t bytes() const { return sizeof(*this) + data.capacity(); }
+    };
+
+    using handle = std::shared_ptr<const blob>;
+
+    handle intern(std::string_view state) {
+        const size_t h = std::hash<std::string_view>{}(state);
+        auto data = ls::lz_compress(state);
+        data.shrink_to_fit();
+
+        // The codec is deterministic, so equal text gives equal blocks and
+        // the comparison never needs to decompress.
+        auto& slot = m_by_hash[h];
+        if (auto existing = slot.lock()) {
+            if (existing->raw_size == state.size() && existing->data == data)
+                return existing;
+            return std::make_shared<const blob>(blob{ h, state.size(), std::move(data) });
+        }
+
+        auto b = std::make_shared<const blob>(blob{ h, state.size(), std::move(data) });
+        slot = b;
+        if (m_by_hash.size() > 2 * m_pruned_size) prune();
+        return b;
+    }
+
+    static std::string load(const handle& h) {
+        return h ? ls::lz_decompress_string(h->data, h->raw_size) : std::string();
+    }
+
+    void clear() { m_by_hash.clear(); }
+
+private:
+    void prune() {
+        std::erase_if(m_by_hash, [](const auto& kv) { return kv.second.expired(); });
+        m_pruned_size = std::max<size_t>(m_by_hash.size(), 64);
+    }
+
+    std::unordered_map<size_t, std::weak_ptr<const blob>> m_by_hash;
+    size_t m_pruned_size = 64;
+};
@@ -35,15 +35,17 @@ tag_panel::resolved_color tag_panel::resolve_color(
         ls::tag_registry& reg,
         const std::string& full_id,
         int l0_pal_idx) const {
-    std::string id = full_id;
-    bool inherited = false;
-    while (true) {
-        if (auto c = reg.get_color(id))
-            return { *c, inherited };
-        auto dot = id.rfind('.');
-        if (dot == std::string::npos) break;
-        id = id.substr(0, dot);
-        inherited = true;
+    // Walk the ancestors by clearing tag levels; colors are keyed by tag, so
+    // this never touches a string.
+    if (auto t = reg.parse(full_id)) {
+        const ls::tag chain[] = {
+            *t,
+            ls::tag::symbolic(t->l0(), t->l1(), 0),
+            ls::tag::symbolic(t->l0(), 0, 0),
+        };
+        for (int i = 0; i < 3; ++i)
+            if (auto c = reg.get_color(chain[i]))
+                return { *c, chain[i] != *t };
     }
     return { palette_color(l0_pal_idx), true };
 }
@@ -0,0 +1,173 @@
+#include "binary_visitor.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace ls {
+
+namespace {
+
+// Field kinds. Stored in the file; append only.
+enum : uint8_t {
+    k_double = 1,
+    k_int    = 2,
+    k_vec2   = 3,
+    k_string = 4,
+    k_tag    = 5,
+};
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// byte_writer / byte_reader
+// ---------------------------------------------------------------------------
+
+void byte_writer::f32(float v) { u32(std::bit_cast<uint32_t>(v)); }
+void byte_writer::f64(double v) { u64(std::bit_cast<uint64_t>(v)); }
+
+void byte_writer::str(std::string_view s) {
+    u32(uint32_t(s.size()));
+    bytes(s.data(), s.size());
+}
+
+void byte_writer::bytes(const void* data, size_t size) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    m_bytes.insert(m_bytes.end(), p, p + size);
+}
+
+void byte_writer::patch_u32(size_t offset, uint32_t v) {
+    for (int i = 0; i < 4; ++i) m_bytes[offset + i] = uint8_t(v >> (8 * i));
+}
+
+float byte_reader::f32() { return std::bit_cast<float>(u32()); }
+double byte_reader::f64() { return std::bit_cast<double>(u64()); }
+
+std::string_view byte_reader::str() {
+    const uint32_t n = u32();
+    return { reinterpret_cast<const char*>(bytes(n)), n };
+}
+
+const uint8_t* byte_reader::bytes(size_t size) {
+    require(size);
+    const uint8_t* p = m_data + m_pos;
+    m_pos += size;
+    return p;
+}
+
+uint64_t byte_reader::get(int n) {
+    require(n);
+    uint64_t v = 0;
+    for (int i = 0; i < n; ++i) v |= uint64_t(m_data[m_pos + i]) << (8 * i);
+    m_pos += n;
+    return v;
+}
+
+void byte_reader::require(size_t n) const {
+    if (n > m_size - m_pos)
+        throw std::runtime_error("Unexpected end of binary data");
+}
+
+// ---------------------------------------------------------------------------
+// binary_writer
+// ---------------------------------------------------------------------------
+
+void binary_writer::field(std::string_view name, uint8_t kind) {
+    auto it = std::find(m_names.begin(), m_names.end(), name);
+    if (it == m_names.end()) it = m_names.emplace(m_names.end(), name);
+    m_out.u32(uint32_t(it - m_names.begin()));
+    m_out.u8(kind);
+    ++m_count;
+}
+
+void binary_writer::visit(std::string_view name, double& v) {
+    field(name, k_double);
+    m_out.f64(v);
+}
+
+void binary_writer::visit(std::string_view name, int& v) {
+    field(name, k_int);
+    m_out.i32(v);
+}
+
+void binary_writer::visit(std::string_view name, vec2& v) {
+    field(name, k_vec2);
+    m_out.f32(v.x);
+    m_out.f32(v.y);
+}
+
+void binary_writer::visit(std::string_view name, std::string& v) {
+    field(name, k_string);
+    m_out.str(v);
+}
+
+void binary_writer::visit(std::string_view name, tag& t) {
+    field(name, k_tag);
+    m_out.u64(t.raw());
+}
+
+// ---------------------------------------------------------------------------
+// binary_reader
+// ---------------------------------------------------------------------------
+
+void binary_reader::read(byte_reader& in) {
+    m_fields.clear();
+    m_next = 0;
+    const uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t name = in.u32();
+        if (name >= m_names.size())
+            throw std::runtime_error("Invalid field name index in binary graph");
+        field f{ m_names[name], in.u8(), 0, {} };
+        switch (f.kind) {
+            case k_double:
+            case k_tag:    f.bits = in.u64(); break;
+            case k_int:    f.bits = in.u32(); break;
+            case k_vec2:   f.bits = in.u64(); break;   // two packed f32
+            case k_string: f.text = in.str(); break;
+            default:
+                throw std::runtime_error("Unknown field kind in binary graph");
+        }
+        m_fields.push_back(f);
+    }
+}
+
+const binary_reader::field* binary_reader::lookup(std::string_view name, uint8_t kind) {
+    auto hit = [&](size_t i) {
+        return m_fields[i].name == name && m_fields[i].kind == kind;
+    };
+    if (m_next < m_fields.size() && hit(m_next))
+        return &m_fields[m_next++];
+    for (size_t i = 0; i < m_fields.size(); ++i) {
+        if (hit(i)) {
+            m_next = i + 1;
+            return &m_fields[i];
+        }
+    }
+    return nullptr;
+}
+
+void binary_reader::visit(std::string_view name, double& v) {
+    if (const field* f = lookup(name, k_double)) v = std::bit_cast<double>(f->bits);
+}
+
+void binary_reader::visit(std::string_view name, int& v) {
+    if (const field* f = lookup(name, k_int)) v = int32_t(uint32_t(f->bits));
+}
+
+void binary_reader::visit(std::string_view name, vec2& v) {
+    if (const field* f = lookup(name, k_vec2)) {
+        v.x = std::bit_cast<float>(uint32_t(f->bits));
+        v.y = std::bit_cast<float>(uint32_t(f->bits >> 32));
+    }
+}
+
+void binary_reader::visit(std::string_view name, std::string& v) {
+    if (const field* f = lookup(name, k_string)) v.assign(f->text);
+}
+
+void binary_reader::visit(std::string_view name, tag& t) {
+    if (const field* f = lookup(name, k_tag)) t = tag(f->bits);
+}
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "node_visitor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ls {
+
+/// Append-only little-endian byte buffer used by the binary formats.
+class byte_writer {
+public:
+    void u8(uint8_t v) { m_bytes.push_back(v); }
+    void u16(uint16_t v) { put(v, 2); }
+    void u32(uint32_t v) { put(v, 4); }
+    void u64(uint64_t v) { put(v, 8); }
+    void i32(int32_t v) { put(uint32_t(v), 4); }
+    void f32(float v);
+    void f64(double v);
+    void str(std::string_view s);
+    void bytes(const void* data, size_t size);
+
+    /// Overwrite a u32 written earlier (e.g. a count known only afterwards).
+    void patch_u32(size_t offset, uint32_t v);
+
+    size_t size() const { return m_bytes.size(); }
+    std::vector<uint8_t>& buffer() { return m_bytes; }
+    std::vector<uint8_t> take() { return std::move(m_bytes); }
+
+private:
+    void put(uint64_t v, int n) {
+        for (int i = 0; i < n; ++i) m_bytes.push_back(uint8_t(v >> (8 * i)));
+    }
+
+    std::vector<uint8_t> m_bytes;
+};
+
+/// Bounds-checked cursor over a little-endian byte range. Reading past the
+/// end throws std::runtime_error, so a truncated file fails cleanly.
+class byte_reader {
+public:
+    byte_reader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    uint8_t  u8()  { return uint8_t(get(1)); }
+    uint16_t u16() { return uint16_t(get(2)); }
+    uint32_t u32() { return uint32_t(get(4)); }
+    uint64_t u64() { return get(8); }
+    int32_t  i32() { return int32_t(uint32_t(get(4))); }
+    float    f32();
+    double   f64();
+
+    /// Length-prefixed string, viewing the underlying buffer.
+    std::string_view str();
+
+    /// Raw view of the next `size` bytes.
+    const uint8_t* bytes(size_t size);
+
+    size_t offset() const { return m_pos; }
+    size_t remaining() const { return m_size - m_pos; }
+    bool at_end() const { return m_pos == m_size; }
+
+private:
+    uint64_t get(int n);
+    void require(size_t n) const;
+
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+};
+
+
+/// Writes a node's persistent state as binary fields.
+///
+/// Each field is (name index, kind, value). Names go through a string table
+/// shared by the whole file, so a graph with a thousand noise nodes stores
+/// "density" once.
+class binary_writer final : public node_visitor {
+public:
+    binary_writer(byte_writer& out, std::vector<std::string>& names)
+        : m_out(out), m_names(names) {}
+
+    void visit(std::string_view name, double& v) override;
+    void visit(std::string_view name, int& v) override;
+    void visit(std::string_view name, vec2& v) override;
+    void visit(std::string_view name, std::string& v) override;
+    void visit(std::string_view name, tag& t) override;
+
+    /// Number of fields written so far.
+    uint32_t count() const { return m_count; }
+
+private:
+    void field(std::string_view name, uint8_t kind);
+
+    byte_writer& m_out;
+    std::vector<std::string>& m_names;
+    uint32_t m_count = 0;
+};
+
+
+/// Reads a node's persistent state from binary fields.
+///
+/// `read()` decodes the next node's fields into a small table that is reused
+/// from node to node. Since accept() visits members in the order they were
+/// written, each lookup normally hits the next entry; a changed node layout
+/// falls back to a scan. As with json_reader, missing fields (or fields of
+/// another kind) leave the member at its default.
+class binary_reader final : public node_visitor {
+public:
+    /// `names` is the file's field-name table.
+    explicit binary_reader(const std::vector<std::string_view>& names) : m_names(names) {}
+
+    /// Decode the next field block from `in`.
+    void read(byte_reader& in);
+
+    void visit(std::string_view name, double& v) override;
+    void visit(std::string_view name, int& v) override;
+    void visit(std::string_view name, vec2& v) override;
+    void visit(std::string_view name, std::string& v) override;
+    void visit(std::string_view name, tag& t) override;
+
+private:
+    struct field {
+        std::string_view name;
+        uint8_t kind;
+        uint64_t bits;           // numeric payload (double/int/tag/vec2)
+        std::string_view text;   // string payload
+    };
+
+    const field* lookup(std::string_view name, uint8_t kind);
+
+    const std::vector<std::string_view>& m_names;
+    std::vector<field> m_fields;
+    size_t m_next = 0;
+};
+
+}
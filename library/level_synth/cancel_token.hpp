@@ -0,0 +1,23 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace ls {
+
+/// Shared flag for abandoning work cooperatively. Copies refer to the same
+/// flag: the code that starts the work keeps one to call cancel(), the
+/// work polls cancelled() at points where stopping is safe. A
+/// default-constructed token can still be cancelled through its copies.
+class cancel_token {
+public:
+    cancel_token() : m_flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { m_flag->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return m_flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_flag;
+};
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "rect.hpp"
+
+namespace ls {
+
+/// One bit per cell of a width × height area.
+///
+/// Rows start on a 64-bit word boundary so that kernels can fill a row at a
+/// time and set operations never need to shift. Padding bits past the end of
+/// a row are always zero.
+class cell_mask {
+public:
+    cell_mask() = default;
+
+    cell_mask(int width, int height)
+        : m_width(width), m_height(height), m_stride((width + 63) / 64),
+          m_words(static_cast<size_t>(m_stride) * height, 0) {}
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    /// Words per row.
+    int stride() const { return m_stride; }
+
+    uint64_t* row(int y) { return m_words.data() + static_cast<size_t>(y) * m_stride; }
+    const uint64_t* row(int y) const { return m_words.data() + static_cast<size_t>(y) * m_stride; }
+
+    const std::vector<uint64_t>& words() const { return m_words; }
+
+    bool test(int x, int y) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+
+    void set(int x, int y, bool value = true) {
+        const uint64_t bit = uint64_t(1) << (x & 63);
+        if (value) row(y)[x >> 6] |= bit;
+        else       row(y)[x >> 6] &= ~bit;
+    }
+
+    /// Set cells [x0, x1) of row y.
+    void set_range(int y, int x0, int x1) {
+        uint64_t* r = row(y);
+        while (x0 < x1) {
+            const int bit = x0 & 63;
+            const int n   = std::min(64 - bit, x1 - x0);
+            const uint64_t bits = (n == 64) ? ~uint64_t(0) : ((uint64_t(1) << n) - 1) << bit;
+            r[x0 >> 6] |= bits;
+            x0 += n;
+        }
+    }
+
+    /// Number of set cells.
+    size_t count() const {
+        size_t n = 0;
+        for (uint64_t w : m_words) n += std::popcount(w);
+        return n;
+    }
+
+    bool any() const {
+        return std::any_of(m_words.begin(), m_words.end(), [](uint64_t w) { return w != 0; });
+    }
+
+    /// Calls fn(x, y) for every set cell in row-major order.
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (int y = 0; y < m_height; ++y) {
+            const uint64_t* r = row(y);
+            for (int w = 0; w < m_stride; ++w) {
+                uint64_t bits = r[w];
+                while (bits) {
+                    fn(w * 64 + std::countr_zero(bits), y);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+    /// Coordinates of every set cell, offset by (origin_x, origin_y).
+    std::vector<cell_coord> cells(int origin_x = 0, int origin_y = 0) const {
+        std::vector<cell_coord> out;
+        out.reserve(count());
+        for_each([&](int x, int y) { out.push_back({ origin_x + x, origin_y + y }); });
+        return out;
+    }
+
+    cell_mask& operator&=(const cell_mask& o) { return combine(o, [](uint64_t a, uint64_t b) { return a & b; }); }
+    cell_mask& operator|=(const cell_mask& o) { return combine(o, [](uint64_t a, uint64_t b) { return a | b; }); }
+    cell_mask& operator^=(const cell_mask& o) { return combine(o, [](uint64_t a, uint64_t b) { return a ^ b; }); }
+
+    /// Remove the cells set in `o` (this & ~o).
+    cell_mask& subtract(const cell_mask& o) { return combine(o, [](uint64_t a, uint64_t b) { return a & ~b; }); }
+
+    /// Flip every cell.
+    cell_mask& invert() {
+        for (auto& w : m_words) w = ~w;
+        clear_padding();
+        return *this;
+    }
+
+    friend cell_mask operator&(cell_mask a, const cell_mask& b) { return a &= b; }
+    friend cell_mask operator|(cell_mask a, const cell_mask& b) { return a |= b; }
+    friend cell_mask operator^(cell_mask a, const cell_mask& b) { return a ^= b; }
+    friend cell_mask operator~(cell_mask a) { return a.invert(); }
+
+    bool operator==(const cell_mask&) const = default;
+
+private:
+    template <typename Op>
+    cell_mask& combine(const cell_mask& o, Op op) {
+        assert(m_width == o.m_width && m_height == o.m_height && "cell_mask size mismatch");
+        for (size_t i = 0; i < m_words.size(); ++i)
+            m_words[i] = op(m_words[i], o.m_words[i]);
+        return *this;
+    }
+
+    void clear_padding() {
+        const int tail = m_width & 63;
+        if (tail == 0) return;
+        const uint64_t keep = (uint64_t(1) << tail) - 1;
+        for (int y = 0; y < m_height; ++y)
+            row(y)[m_stride - 1] &= keep;
+    }
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_stride = 0;
+    std::vector<uint64_t> m_words;
+};
+
+}
@@ -0,0 +1,42 @@
+#include "cost_model.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+
+namespace ls {
+
+namespace {
+
+// Window of the running average; older samples fade out beyond it.
+constexpr int k_window = 8;
+
+} // anonymous namespace
+
+int cost_model::size_class(size_t cells) {
+    return static_cast<int>(std::bit_width(cells));
+}
+
+void cost_model::record(const std::string& type, size_t cells, double us) {
+    auto& e = m_entries[{ type, size_class(cells) }];
+    if (e.samples < k_window) ++e.samples;
+    e.mean_us += (us - e.mean_us) / e.samples;
+}
+
+std::optional<double> cost_model::predict(const std::string& type, size_t cells) const {
+    const int cls = size_class(cells);
+    const estimate* best = nullptr;
+    int best_cls = 0;
+    for (auto it = m_entries.lower_bound({ type, 0 }); it != m_entries.end() && it->first.first == type; ++it) {
+        if (!best || std::abs(it->first.second - cls) < std::abs(best_cls - cls)) {
+            best = &it->second;
+            best_cls = it->first.second;
+        }
+    }
+    if (!best) return std::nullopt;
+    // Classes are powers of two; class 0 (no grid) doesn't scale.
+    if (cls == 0 || best_cls == 0) return best->mean_us;
+    return std::ldexp(best->mean_us, cls - best_cls);
+}
+
+}
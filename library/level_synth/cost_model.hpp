@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace ls {
+
+/// Running estimates of how long each node type takes to evaluate, grouped
+/// by grid size. eval_engine feeds it from every evaluation and uses it to
+/// start long dependency chains first.
+class cost_model {
+public:
+    struct estimate {
+        double mean_us = 0;
+        int samples = 0;
+    };
+
+    /// Type name and size class (see size_class()).
+    using key = std::pair<std::string, int>;
+
+    /// Adds a measurement. Once a few samples are in, newer ones weigh
+    /// more, so estimates follow changes in machine load.
+    void record(const std::string& type, size_t cells, double us);
+
+    /// Expected time for `type` on a grid of `cells` cells. Falls back to
+    /// the nearest measured size class of the type, scaled by the cell
+    /// count ratio. Empty if the type was never measured.
+    std::optional<double> predict(const std::string& type, size_t cells) const;
+
+    const std::map<key, estimate>& entries() const { return m_entries; }
+    void clear() { m_entries.clear(); }
+
+    /// Bits in the cell count: 0 for nodes without grids, 1 for one cell,
+    /// 13 for 64x64. Each class doubles the size of the one before.
+    static int size_class(size_t cells);
+
+private:
+    std::map<key, estimate> m_entries;
+};
+
+}
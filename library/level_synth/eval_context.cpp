@@ -1,5 +1,7 @@
 #include "eval_context.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 namespace ls {
@@ -30,6 +32,24 @@ void eval_context::set_output_number(const std::string& pin_name, double value)
     m_outputs[pin_name] = value;
 }
 
+double eval_context::cell_random(int x, int y) const {
+    if (m_region) {
+        x += m_region->x;
+        y += m_region->y;
+    }
+    // splitmix64 finalizer over the seed and both coordinates.
+    uint64_t h = m_cell_seed ^ (uint64_t(uint32_t(x)) << 32 | uint32_t(y));
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return double(h >> 11) * 0x1.0p-53;
+}
+
+double eval_context::spatial(double cells) const {
+    if (m_resolution == 1 || cells <= 0) return cells;
+    return std::max(1.0, std::round(cells * m_resolution));
+}
+
 void eval_context::set_output_grid(const std::string& pin_name, std::shared_ptr<grid> grid) {
     m_outputs[pin_name] = std::move(grid);
 }
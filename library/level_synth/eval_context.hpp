@@ -1,11 +1,16 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <random>
 #include <string>
 #include <unordered_map>
 
+#include "cancel_token.hpp"
 #include "pin.hpp"
+#include "rect.hpp"
 
 namespace ls {
 
@@ -21,12 +26,65 @@ public:
     void set_output_grid(const std::string& pin_name, std::shared_ptr<grid> grid);
     std::mt19937& rng() { return m_rng; }
 
+    /// World cells the node's grids cover when the engine evaluates by
+    /// region (eval_engine::evaluate_region): grid inputs arrive cropped to
+    /// it, and nodes without grid inputs should produce grids of its size.
+    /// Empty when evaluating the whole graph.
+    const std::optional<rect>& region() const { return m_region; }
+
+    /// Random number in [0, 1) for cell (x, y) of the node's grids, derived
+    /// from the seed, the node id and the cell's world coordinates. Unlike
+    /// rng(), a cell gets the same value whichever region it is evaluated
+    /// in, so neighbouring regions join without seams.
+    double cell_random(int x, int y) const;
+
+    /// Fraction of full resolution the graph is evaluated at: 1, or less
+    /// for previews (eval_engine::evaluate_progressive).
+    double resolution() const { return m_resolution; }
+
+    /// A length in cells (a radius, the iteration count of a stencil)
+    /// scaled to resolution(), rounded and kept at least 1 if it was
+    /// positive. Nodes pass such parameters through this so previews keep
+    /// their proportions.
+    double spatial(double cells) const;
+
+    /// True once the evaluation this node runs in has been cancelled.
+    /// Long-running nodes poll it at convenient points (between iterations)
+    /// and return false; their outputs are then discarded.
+    bool cancelled() const { return m_cancel && m_cancel->cancelled(); }
+
+    /// True when the node runs inside eval_engine::step() and the frame's
+    /// budget is spent. Long-running nodes check it at points they can
+    /// resume from, keep their progress in resume_state(), and return
+    /// suspend(); evaluate() is then called again with the same context in
+    /// a later frame.
+    bool should_yield() const { return m_deadline && std::chrono::steady_clock::now() >= *m_deadline; }
+
+    /// Return value for evaluate() when yielding. Always false.
+    bool suspend() { m_suspended = true; return false; }
+
+    /// Per-evaluation scratch state that survives suspend(), created on
+    /// first use.
+    template <typename T>
+    T& resume_state() {
+        if (!m_resume) m_resume = std::make_shared<T>();
+        return *static_cast<T*>(m_resume.get());
+    }
+
 private:
     friend class eval_engine;
 
     std::unordered_map<std::string, pin_value> m_inputs;
     std::unordered_map<std::string, pin_value> m_outputs;
     std::mt19937 m_rng;
+    std::optional<rect> m_region;
+    uint64_t m_cell_seed = 0;
+    double m_resolution = 1;
+    const cancel_token* m_cancel = nullptr;
+    std::optional<std::chrono::steady_clock::time_point> m_deadline;
+    std::shared_ptr<void> m_resume;
+    bool m_suspended = false;
+    double m_spent_us = 0;      // in evaluate(), over all slices
 };
 
 }
\ No newline at end of file
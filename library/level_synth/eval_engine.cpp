@@ -1,14 +1,186 @@
 #include "eval_engine.hpp"
 #include "eval_context.hpp"
+#include "grid.hpp"
 #include "node.hpp"
 #include "node_graph.hpp"
+#include "node_registry.hpp"
+#include "node_visitor.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <queue>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <typeinfo>
+#include <unordered_set>
 
 namespace ls {
 
+namespace {
+
+// The bytes of a node key. Strings are length-prefixed, so different field
+// sequences never encode the same.
+class key_encoder {
+public:
+    void bytes(const void* p, size_t n) { m_out.append(static_cast<const char*>(p), n); }
+    template <typename T>
+    void raw(const T& v) { bytes(&v, sizeof(v)); }
+    void str(std::string_view s) { raw(s.size()); bytes(s.data(), s.size()); }
+
+    std::string take() { return std::move(m_out); }
+
+private:
+    std::string m_out;
+};
+
+// 64-bit FNV-1a.
+uint64_t fnv1a(std::string_view s) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : s) h = (h ^ c) * 0x100000001b3ull;
+    return h;
+}
+
+// Feeds a node's visited state to a key. Name and position are editor
+// metadata that evaluate() doesn't read, so they don't count.
+class key_writer final : public node_visitor {
+public:
+    explicit key_writer(key_encoder& e) : m_h(e) {}
+
+    void visit(std::string_view name, double& v) override      { field(name, v); }
+    void visit(std::string_view name, int& v) override         { field(name, v); }
+    void visit(std::string_view name, vec2& v) override        { field(name, v); }
+    void visit(std::string_view name, tag& t) override         { field(name, t.raw()); }
+    void visit(std::string_view name, std::string& v) override {
+        if (name == "name") return;
+        m_h.str(name);
+        m_h.str(v);
+    }
+
+private:
+    template <typename T>
+    void field(std::string_view name, const T& v) {
+        if (name == "position") return;
+        m_h.str(name);
+        m_h.raw(v);
+    }
+
+    key_encoder& m_h;
+};
+
+std::string type_name(const node& n) {
+    const auto* reg = node_registry::instance().find(n);
+    return reg ? reg->type_name : typeid(n).name();
+}
+
+// The `want` part of a grid output that covers `extent`. Grids that don't
+// match `extent` come from nodes that ignore regions and pass unchanged.
+pin_value crop(const pin_value& v, const rect& extent, const rect& want) {
+    const auto* g = std::get_if<std::shared_ptr<grid>>(&v);
+    if (!g || !*g || extent == want) return v;
+    const grid& src = **g;
+    if (src.width() != extent.width || src.height() != extent.height) return v;
+
+    auto out = std::make_shared<grid>(want.width, want.height);
+    tag* dst = out->mutable_data();
+    for (int y = 0; y < want.height; ++y) {
+        const tag* row = src.data() + size_t(want.y - extent.y + y) * src.width() + (want.x - extent.x);
+        std::copy_n(row, want.width, dst + size_t(y) * want.width);
+    }
+    return out;
+}
+
+bool grid_pin(const node& n, const std::string& name, pin_direction dir) {
+    for (const auto& p : n.descriptor().pins)
+        if (p.name == name && p.direction == dir) return p.type == pin_type::grid;
+    return false;
+}
+
+size_t largest_grid(const std::unordered_map<std::string, pin_value>& values, size_t cells = 0) {
+    for (const auto& [name, v] : values)
+        if (const auto* g = std::get_if<std::shared_ptr<grid>>(&v); g && *g)
+            cells = std::max(cells, size_t((*g)->width()) * size_t((*g)->height()));
+    return cells;
+}
+
+size_t grid_bytes(const std::unordered_map<std::string, pin_value>& values) {
+    size_t bytes = 0;
+    for (const auto& [name, v] : values)
+        if (const auto* g = std::get_if<std::shared_ptr<grid>>(&v); g && *g)
+            bytes += size_t((*g)->width()) * size_t((*g)->height()) * sizeof(tag);
+    return bytes;
+}
+
+double elapsed_us(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // anonymous namespace
+
+eval_engine::eval_engine()
+    : m_mutex(std::make_unique<std::mutex>()), m_exclusive(std::make_unique<std::mutex>()),
+      m_key_ids(0, key_bucket{ fnv1a }) {}
+
+eval_engine::~eval_engine() = default;
+eval_engine::eval_engine(eval_engine&&) noexcept = default;
+eval_engine& eval_engine::operator=(eval_engine&&) noexcept = default;
+
+void eval_engine::set_key_hash(key_hash hash) {
+    // Rebucket the interned keys; their ids, and so the cache, stay valid.
+    key_table table(m_key_ids.size(), key_bucket{ std::move(hash) });
+    table.insert(m_key_ids.begin(), m_key_ids.end());
+    m_key_ids = std::move(table);
+}
+
+// Identity of a node's computation: type, visited state, and for each input
+// the key of the node feeding it. Stochastic nodes also include the seed
+// and, unless they are mergeable, their id (the RNG is seeded by both).
+// Empty for nodes that aren't pure or read from one that isn't.
+//
+// The encoding is interned in m_key_ids, which buckets by hash but compares
+// encodings in full, so equal keys mean equal computations even when hashes
+// collide. Inputs are encoded by their interned keys, which keeps each
+// encoding small.
+std::optional<uint64_t> eval_engine::node_key(const node_graph& graph, int node_id, node& n, int master_seed,
+                                              const std::unordered_map<int, std::optional<uint64_t>>& keys) {
+    const auto& desc = n.descriptor();
+    if (!desc.has(node_flag_pure)) return std::nullopt;
+
+    key_encoder h;
+    h.str(typeid(n).name());
+    key_writer w(h);
+    n.accept(w);
+    if (n.is_stochastic()) {
+        h.raw(master_seed);
+        if (!n.is_mergeable()) h.raw(node_id);
+    }
+    if (auto r = m_regions.find(node_id); r != m_regions.end()) {
+        h.raw(r->second.out);
+        h.raw(r->second.in);
+    }
+    h.raw(m_divisor);
+
+    std::vector<std::tuple<std::string_view, uint64_t, std::string_view>> inputs;
+    for (const auto& wr : graph.wires()) {
+        if (wr.to_node != node_id) continue;
+        auto it = keys.find(wr.from_node);
+        if (it == keys.end() || !it->second) return std::nullopt;
+        inputs.emplace_back(wr.to_pin, *it->second, wr.from_pin);
+    }
+    std::sort(inputs.begin(), inputs.end());
+    for (const auto& [to_pin, from_key, from_pin] : inputs) {
+        h.str(to_pin);
+        h.raw(from_key);
+        h.str(from_pin);
+    }
+    auto [it, added] = m_key_ids.try_emplace(h.take(), m_next_key_id);
+    if (added) ++m_next_key_id;
+    return it->second;
+}
+
 std::vector<int> eval_engine::topological_sort(const node_graph& graph) const {
     // Gather all node IDs
     std::vector<int> all_ids = graph.node_ids();
@@ -58,6 +230,13 @@ eval_context eval_engine::build_context(const node_graph& graph, int node_id, in
     // Seed RNG: hash of master_seed and node_id
     std::size_t seed = std::hash<int>{}(master_seed) ^ (std::hash<int>{}(node_id) << 1);
     ctx.m_rng.seed(static_cast<std::mt19937::result_type>(seed));
+    ctx.m_cell_seed = (uint64_t(uint32_t(master_seed)) << 32 | uint32_t(node_id)) * 0x9e3779b97f4a7c15ull;
+    ctx.m_resolution = 1.0 / m_divisor;
+    ctx.m_cancel = m_cancel;
+    ctx.m_deadline = m_deadline;
+
+    const auto plan = m_regions.find(node_id);
+    if (plan != m_regions.end()) ctx.m_region = plan->second.in;
 
     // Populate inputs from upstream cached outputs
     for (const auto& w : graph.wires()) {
@@ -69,31 +248,559 @@ eval_context eval_engine::build_context(const node_graph& graph, int node_id, in
         auto output_it = cache_it->second.outputs.find(w.from_pin);
         if (output_it == cache_it->second.outputs.end()) continue;
 
-        ctx.m_inputs[w.to_pin] = output_it->second;
+        auto from_plan = m_regions.find(w.from_node);
+        if (plan != m_regions.end() && from_plan != m_regions.end())
+            ctx.m_inputs[w.to_pin] = crop(output_it->second, from_plan->second.out, plan->second.in);
+        else
+            ctx.m_inputs[w.to_pin] = output_it->second;
     }
 
     return ctx;
 }
 
 void eval_engine::evaluate(node_graph& graph, int master_seed) {
-    m_cache.clear();
-    auto order = topological_sort(graph);
+    m_regions.clear();
+    run(graph, master_seed);
+}
+
+void eval_engine::evaluate_region(node_graph& graph, const rect& region, int master_seed) {
+    m_regions = plan_regions(graph, region, master_seed);
+    run(graph, master_seed);
+}
+
+bool eval_engine::evaluate(node_graph& graph, int master_seed, const cancel_token& cancel, progress* p) {
+    m_regions.clear();
+    return run(graph, master_seed, &cancel, p);
+}
+
+bool eval_engine::evaluate_progressive(node_graph& graph, int master_seed, const level_callback& on_level,
+                                       const cancel_token& cancel) {
+    for (int divisor : k_preview_divisors) {
+        if (cancel.cancelled()) return false;
+        eval_engine* level = this;
+        if (divisor != 1) {
+            auto& preview = m_previews[divisor];
+            if (!preview) {
+                preview = std::make_unique<eval_engine>();
+                preview->set_key_hash(m_key_ids.hash_function().hash);
+            }
+            preview->m_divisor = divisor;
+            preview->m_threads = m_threads;
+            preview->m_merge_identical = m_merge_identical;
+            preview->m_fuse_pointwise = m_fuse_pointwise;
+            level = preview.get();
+        }
+        level->m_regions.clear();
+        if (!level->run(graph, master_seed, &cancel)) return false;
+        if (on_level) on_level(*level, divisor);
+    }
+    return true;
+}
+
+const eval_engine* eval_engine::preview(int divisor) const {
+    if (divisor == 1) return this;
+    auto it = m_previews.find(divisor);
+    return it != m_previews.end() ? it->second.get() : nullptr;
+}
 
+std::unordered_map<int, eval_engine::region_plan> eval_engine::plan_regions(node_graph& graph, const rect& region,
+                                                                            int master_seed) const {
+    const auto order = topological_sort(graph);
+
+    // Number inputs can change a node's reach (iteration counts), so run
+    // the nodes that only deal in numbers first, on the side.
+    eval_engine numbers;
     for (int id : order) {
-        // Skip if cached
-        if (m_cache.contains(id)) continue;
+        const node* n = graph.find_node(id);
+        const auto& pins = n->descriptor().pins;
+        if (std::any_of(pins.begin(), pins.end(), [](const pin_descriptor& p) { return p.type != pin_type::number; }))
+            continue;
+        try {
+            numbers.evaluate_node(graph, id, master_seed);
+        } catch (const std::exception&) {
+            // An input that depends on grids; reach falls back to members.
+        }
+    }
+
+    std::unordered_map<int, region_plan> plans;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const int id = *it;
+        const node& n = *graph.find_node(id);
+        const auto& wires = graph.wires();
+        const auto& pins = n.descriptor().pins;
+
+        if (std::none_of(wires.begin(), wires.end(), [&](const wire& w) { return w.from_node == id; })
+            && std::any_of(pins.begin(), pins.end(), [](const pin_descriptor& p) { return p.type == pin_type::grid; }))
+            plans[id].out = region;
+        auto plan = plans.find(id);
+        if (plan == plans.end()) continue;
+
+        const bool grid_inputs = std::any_of(wires.begin(), wires.end(), [&](const wire& w) {
+            return w.to_node == id && grid_pin(n, w.to_pin, pin_direction::input);
+        });
+        const int reach = n.stencil_reach(numbers.build_context(graph, id, master_seed));
+        if (reach < 0 && grid_inputs) {
+            const auto* reg = node_registry::instance().find(n);
+            throw std::runtime_error("Can't evaluate " + (reg ? reg->type_name : std::string("node")) +
+                                     " by region: its stencil reach is unknown");
+        }
+        plan->second.in = plan->second.out.expanded(std::max(reach, 0));
 
+        const rect in = plan->second.in;
+        for (const auto& w : wires) {
+            if (w.to_node != id || !grid_pin(n, w.to_pin, pin_direction::input)) continue;
+            auto [from, added] = plans.try_emplace(w.from_node, region_plan{ in, in });
+            if (!added) from->second.out = from->second.out.bounds(in);
+        }
+    }
+    return plans;
+}
+
+eval_engine::run_plan eval_engine::plan_run(node_graph& graph, int master_seed) {
+    m_step.reset();
+    auto previous = std::move(m_cache);
+    m_cache.clear();
+    m_deferred.clear();
+    m_merged_count = 0;
+    m_fused_count = 0;
+    m_reused_count = 0;
+    m_node_stats.clear();
+    const auto order = topological_sort(graph);
+
+    run_plan plan;
+    plan.nodes = int(order.size());
+    std::unordered_map<uint64_t, int> first_with;      // representative per key
+    std::unordered_map<uint64_t, int> previous_by_key;
+    for (const auto& [id, c] : previous)
+        if (c.key) previous_by_key.emplace(*c.key, id);
+
+    for (int id : order) {
         auto* n = graph.find_node(id);
         if (!n) continue;
+        const auto key = plan.keys[id] = node_key(graph, id, *n, master_seed, plan.keys);
+
+        if (key) {
+            const bool mergeable = m_merge_identical && n->is_mergeable();
+            const int rep = mergeable ? first_with.try_emplace(*key, id).first->second : id;
+
+            // Unchanged since the last evaluate(): keep the outputs.
+            if (auto p = previous.find(id); p != previous.end() && p->second.key == key) {
+                m_cache[id] = p->second;
+                ++m_reused_count;
+                m_node_stats[id] = { node_stats::outcome::reused, 0, grid_bytes(p->second.outputs) };
+                continue;
+            }
+            if (rep != id) {
+                plan.reps[id] = rep;
+            } else if (auto q = previous_by_key.find(*key); mergeable && q != previous_by_key.end()) {
+                // An identical node from the last evaluate().
+                m_cache[id] = previous.at(q->second);
+                ++m_merged_count;
+                m_node_stats[id] = { node_stats::outcome::merged, 0, grid_bytes(m_cache[id].outputs) };
+                continue;
+            }
+        }
+        plan.to_run.push_back(id);
+    }
+
+    // Only this run's keys can be hit again.
+    std::unordered_set<uint64_t> live;
+    for (const auto& [id, key] : plan.keys)
+        if (key) live.insert(*key);
+    std::erase_if(m_key_ids, [&](const auto& kv) { return !live.contains(kv.second); });
+    return plan;
+}
+
+bool eval_engine::run(node_graph& graph, int master_seed, const cancel_token* cancel, progress* p) {
+    struct reset {
+        eval_engine& e;
+        ~reset() { e.m_cancel = nullptr; e.m_progress = nullptr; }
+    } guard{ *this };
+    m_cancel = cancel;
+    m_progress = p;
+
+    auto plan = plan_run(graph, master_seed);
+    if (m_progress) {
+        m_progress->total = plan.nodes;
+        m_progress->completed = plan.nodes - int(plan.to_run.size());
+    }
 
-        auto ctx = build_context(graph, id, master_seed);
+    bool done = true;
+    const int threads = m_threads > 0 ? m_threads : int(std::max(1u, std::thread::hardware_concurrency()));
+    if (threads > 1 && plan.to_run.size() > 1) {
+        done = run_parallel(graph, plan, master_seed, threads);
+    } else {
+        for (int id : plan.to_run) {
+            if (m_cancel && m_cancel->cancelled()) {
+                done = false;
+                break;
+            }
+            run_node(graph, id, plan.rep_of(id), plan.keys[id], master_seed);
+            if (m_progress) ++m_progress->completed;
+        }
+    }
+    m_deferred.clear();
+    // A node may have stopped early and left no outputs.
+    return done && !(m_cancel && m_cancel->cancelled());
+}
+
+void eval_engine::begin_steps(node_graph& graph, int master_seed) {
+    m_regions.clear();
+    auto plan = plan_run(graph, master_seed);
+    m_step = std::make_unique<step_state>(step_state{ &graph, master_seed, std::move(plan) });
+}
+
+bool eval_engine::step(double budget_us) {
+    if (!m_step) return true;
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    m_deadline = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::micro>(budget_us));
+
+    auto& s = *m_step;
+    ++s.stats.frames;
+    for (bool first = true; s.next < s.plan.to_run.size(); first = false) {
+        if (!first && clock::now() >= *m_deadline) break;
+        const int id = s.plan.to_run[s.next];
+        if (s.suspended) {
+            eval_context ctx = std::move(*s.suspended);
+            s.suspended.reset();
+            ctx.m_suspended = false;
+            ctx.m_deadline = m_deadline;
+            if (finish_node(*s.graph->find_node(id), id, ctx)) {
+                std::lock_guard lock(*m_mutex);
+                m_cache[id].key = s.plan.keys[id];
+            }
+        } else {
+            run_node(*s.graph, id, s.plan.rep_of(id), s.plan.keys[id], s.seed);
+        }
+        if (s.suspended) break;         // the node yielded; resume next time
+        ++s.next;
+    }
+    m_deadline.reset();
+    s.stats.busy_us += std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    if (s.next < s.plan.to_run.size()) return false;
+
+    m_deferred.clear();
+    m_step_stats = s.stats;
+    m_step.reset();
+    return true;
+}
+
+void eval_engine::run_node(node_graph& graph, int node_id, int rep, std::optional<uint64_t> key, int master_seed) {
+    if (rep != node_id) {
+        std::lock_guard lock(*m_mutex);
+        if (auto r = m_cache.find(rep); r != m_cache.end()) {
+            // Outputs are values or shared_ptr<grid>; copies are cheap.
+            node_cache shared = r->second;
+            m_node_stats[node_id] = { node_stats::outcome::merged, 0, grid_bytes(shared.outputs) };
+            m_cache[node_id] = std::move(shared);
+            ++m_merged_count;
+            return;
+        }
+    }
+
+    node& n = *graph.find_node(node_id);
+    if (m_fuse_pointwise && evaluate_fused(graph, node_id, n, master_seed)) {
+        std::lock_guard lock(*m_mutex);
+        if (auto c = m_cache.find(node_id); c != m_cache.end()) c->second.key = key;
+        return;
+    }
+
+    for (const auto& w : graph.wires())
+        if (w.to_node == node_id) materialize(w.from_node);
+    if (evaluate_node(graph, node_id, master_seed)) {
+        std::lock_guard lock(*m_mutex);
+        m_cache[node_id].key = key;
+    }
+}
+
+bool eval_engine::run_parallel(node_graph& graph, const run_plan& plan, int master_seed, int threads) {
+    const auto& ids = plan.to_run;
+    const auto& reps = plan.reps;
+    // Dependencies among the nodes that run; everything else is cached.
+    std::unordered_map<int, int> waiting;
+    std::unordered_map<int, std::vector<int>> dependents;
+    for (int id : ids) waiting[id] = 0;
+    auto depend = [&](int from, int to) {
+        if (!waiting.contains(from) || !waiting.contains(to)) return;
+        dependents[from].push_back(to);
+        ++waiting[to];
+    };
+    for (const auto& w : graph.wires()) depend(w.from_node, w.to_node);
+    for (const auto& [id, rep] : reps) depend(rep, id);
+
+    // Priority: estimated time from a node's start to the end of the
+    // longest chain of work that depends on it.
+    const auto cells = estimate_cells(graph, ids);
+    std::unordered_map<int, double> priority;
+    for (auto it = ids.rbegin(); it != ids.rend(); ++it) {
+        double after = 0;
+        if (auto d = dependents.find(*it); d != dependents.end())
+            for (int next : d->second) after = std::max(after, priority[next]);
+        const double cost = reps.contains(*it) ? 0 : predict_us(*graph.find_node(*it), cells.at(*it));
+        priority[*it] = cost + after;
+    }
+
+    std::priority_queue<std::pair<double, int>> ready;
+    for (int id : ids)
+        if (waiting[id] == 0) ready.emplace(priority[id], id);
+
+    std::mutex queue_mutex;
+    std::condition_variable changed;
+    size_t remaining = ids.size();
+    std::exception_ptr error;
+    bool stopped = false;
+
+    auto work = [&] {
+        std::unique_lock lock(queue_mutex);
+        for (;;) {
+            changed.wait(lock, [&] { return !ready.empty() || remaining == 0 || error || stopped; });
+            if (remaining == 0 || error || stopped) return;
+            if (m_cancel && m_cancel->cancelled()) {
+                stopped = true;
+                changed.notify_all();
+                return;
+            }
+            const int id = ready.top().second;
+            ready.pop();
+            lock.unlock();
+
+            try {
+                run_node(graph, id, plan.rep_of(id), plan.keys.at(id), master_seed);
+                if (m_progress) ++m_progress->completed;
+            } catch (...) {
+                lock.lock();
+                if (!error) error = std::current_exception();
+                changed.notify_all();
+                return;
+            }
 
-        auto task = n->evaluate(ctx);
-        if (!task) continue; // Evaluation failed, ski  p
+            lock.lock();
+            --remaining;
+            if (auto d = dependents.find(id); d != dependents.end())
+                for (int next : d->second)
+                    if (--waiting[next] == 0) ready.emplace(priority[next], next);
+            changed.notify_all();
+        }
+    };
 
-        // Store outputs in cache
-        m_cache[id].outputs = std::move(ctx.m_outputs);
+    m_parallel = true;
+    {
+        std::vector<std::jthread> helpers;
+        const size_t count = std::min(size_t(threads), ids.size()) - 1;
+        for (size_t i = 0; i < count; ++i) helpers.emplace_back(work);
+        work();
+    }
+    m_parallel = false;
+    if (error) std::rethrow_exception(error);
+    return !stopped;
+}
+
+std::unordered_map<int, size_t> eval_engine::estimate_cells(const node_graph& graph,
+                                                            const std::vector<int>& order) const {
+    std::unordered_map<int, size_t> cells;
+    for (int id : order) {
+        if (auto c = m_cells.find(id); c != m_cells.end()) {
+            cells[id] = c->second;
+            continue;
+        }
+        size_t in = 0;
+        for (const auto& w : graph.wires()) {
+            if (w.to_node != id) continue;
+            if (auto c = cells.find(w.from_node); c != cells.end()) in = std::max(in, c->second);
+            else if (auto m = m_cells.find(w.from_node); m != m_cells.end()) in = std::max(in, m->second);
+        }
+        cells[id] = in;
     }
+    return cells;
+}
+
+double eval_engine::predict_us(const node& n, size_t cells) const {
+    return m_costs.predict(type_name(n), cells).value_or(k_default_cost_us);
+}
+
+double eval_engine::estimate_node_us(const node_graph& graph, int node_id) const {
+    const node* n = graph.find_node(node_id);
+    if (!n) return 0;
+    return predict_us(*n, estimate_cells(graph, topological_sort(graph)).at(node_id));
+}
+
+eval_engine::time_estimate eval_engine::estimate_time(const node_graph& graph) const {
+    const auto order = topological_sort(graph);
+    const auto cells = estimate_cells(graph, order);
+
+    time_estimate t;
+    std::unordered_map<int, double> finish;
+    for (int id : order) {
+        const node* n = graph.find_node(id);
+        const double cost = n ? predict_us(*n, cells.at(id)) : 0;
+        double start = 0;
+        for (const auto& w : graph.wires())
+            if (w.to_node == id) start = std::max(start, finish[w.from_node]);
+        finish[id] = start + cost;
+        t.total_us += cost;
+        t.critical_path_us = std::max(t.critical_path_us, finish[id]);
+    }
+    return t;
+}
+
+// A pointwise node with no other outputs whose grid feeds exactly one
+// node, at that node's pointwise input, can leave its grid unwritten.
+bool eval_engine::ends_chain(const node_graph& graph, int node_id, const node& n) const {
+    const auto& pw = *n.descriptor().pointwise;
+    const wire* out = nullptr;
+    for (const auto& w : graph.wires()) {
+        if (w.from_node != node_id) continue;
+        if (out || w.from_pin != pw.output) return true;
+        out = &w;
+    }
+    if (!out) return true;
+    const node* next = graph.find_node(out->to_node);
+    if (!next) return true;
+    const auto& next_pw = next->descriptor().pointwise;
+    return !next_pw || next_pw->input != out->to_pin;
+}
+
+bool eval_engine::evaluate_fused(node_graph& graph, int node_id, node& n, int master_seed) {
+    const auto& desc = n.descriptor();
+    if (!desc.pointwise) return false;
+    const auto& pw = *desc.pointwise;
+    for (const auto& p : desc.pins)
+        if (p.direction == pin_direction::output && p.name != pw.output) return false;
+
+    const wire* in = nullptr;
+    for (const auto& w : graph.wires())
+        if (w.to_node == node_id && w.to_pin == pw.input) in = &w;
+    if (!in) return false;
+    // The kernel runs wherever the chain ends, possibly alongside anything.
+    if (m_parallel && !desc.has(node_flag_thread_safe)) return false;
+
+    std::unique_lock lock(*m_mutex);
+    auto kernel = n.pointwise_kernel(build_context(graph, node_id, master_seed));
+    if (!kernel) return false;
+
+    pointwise_chain chain;
+    if (auto d = m_deferred.find(in->from_node); d != m_deferred.end()) {
+        chain = std::move(d->second);
+        m_deferred.erase(d);
+    } else {
+        const pin_value* src = get_output(in->from_node, in->from_pin);
+        const auto* g = src ? std::get_if<std::shared_ptr<grid>>(src) : nullptr;
+        if (!g || !*g) return false;
+        chain.source = *g;
+        auto from_plan = m_regions.find(in->from_node);
+        auto plan = m_regions.find(node_id);
+        if (from_plan != m_regions.end() && plan != m_regions.end())
+            chain.source = std::get<std::shared_ptr<grid>>(crop(*g, from_plan->second.out, plan->second.in));
+    }
+    chain.kernels.push_back(std::move(kernel));
+    chain.types.push_back(type_name(n));
+    chain.output = pw.output;
+
+    if (!ends_chain(graph, node_id, n)) {
+        m_deferred[node_id] = std::move(chain);
+        ++m_fused_count;
+        m_node_stats[node_id] = { node_stats::outcome::fused };
+        return true;
+    }
+    lock.unlock();
+    const auto start = std::chrono::steady_clock::now();
+    auto out = run_chain(chain);
+    const double us = elapsed_us(start);
+    lock.lock();
+    m_cells[node_id] = size_t(out->width()) * size_t(out->height());
+    record_chain(chain, m_cells[node_id], us);
+    m_node_stats[node_id] = { node_stats::outcome::evaluated, us, m_cells[node_id] * sizeof(tag) };
+    m_cache[node_id].outputs[pw.output] = std::move(out);
+    return true;
+}
+
+void eval_engine::materialize(int node_id) {
+    std::unique_lock lock(*m_mutex);
+    auto d = m_deferred.find(node_id);
+    if (d == m_deferred.end()) return;
+    auto chain = std::move(d->second);
+    m_deferred.erase(d);
+    --m_fused_count;
+
+    lock.unlock();
+    const auto start = std::chrono::steady_clock::now();
+    auto out = run_chain(chain);
+    const double us = elapsed_us(start);
+    lock.lock();
+    m_cells[node_id] = size_t(out->width()) * size_t(out->height());
+    record_chain(chain, m_cells[node_id], us);
+    m_node_stats[node_id] = { node_stats::outcome::evaluated, us, m_cells[node_id] * sizeof(tag) };
+    m_cache[node_id].outputs[chain.output] = std::move(out);
+}
+
+// Fused nodes have no time of their own, so the pass is split evenly over
+// the chain's node types. Without this, pointwise types would never be
+// measured and the scheduler would always guess k_default_cost_us for them.
+void eval_engine::record_chain(const pointwise_chain& chain, size_t cells, double us) {
+    for (const auto& type : chain.types)
+        m_costs.record(type, cells, us / double(chain.types.size()));
+}
+
+std::shared_ptr<grid> eval_engine::run_chain(const pointwise_chain& chain) {
+    const grid& src = *chain.source;
+    const int w = src.width();
+    auto out = std::make_shared<grid>(w, src.height());
+    tag* dst = out->mutable_data();
+
+    // Row at a time, so every kernel after the first works on a row that
+    // is still in cache.
+    for (int y = 0; y < src.height(); ++y) {
+        const tag* in_row = src.data() + size_t(y) * w;
+        tag* out_row = dst + size_t(y) * w;
+        chain.kernels.front()(in_row, out_row, w);
+        for (size_t k = 1; k < chain.kernels.size(); ++k)
+            chain.kernels[k](out_row, out_row, w);
+    }
+    return out;
+}
+
+bool eval_engine::evaluate_node(node_graph& graph, int node_id, int master_seed) {
+    auto* n = graph.find_node(node_id);
+    if (!n) return false;
+
+    std::unique_lock lock(*m_mutex);
+    auto ctx = build_context(graph, node_id, master_seed);
+    lock.unlock();
+    return finish_node(*n, node_id, ctx);
+}
+
+// Runs evaluate() in `ctx` and caches the outputs. A node that suspends
+// (see eval_context::suspend) parks its context in m_step instead.
+bool eval_engine::finish_node(node& n, int node_id, eval_context& ctx) {
+    std::unique_lock<std::mutex> exclusive;
+    if (!n.descriptor().has(node_flag_thread_safe)) exclusive = std::unique_lock(*m_exclusive);
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = n.evaluate(ctx);
+    ctx.m_spent_us += elapsed_us(start);
+    if (exclusive) exclusive.unlock();
+
+    if (ctx.m_suspended && m_step) {
+        m_step->suspended = std::move(ctx);
+        return false;
+    }
+
+    if (auto plan = m_regions.find(node_id); plan != m_regions.end())
+        for (auto& [name, v] : ctx.m_outputs) v = crop(v, plan->second.in, plan->second.out);
+
+    const size_t cells = largest_grid(ctx.m_outputs, largest_grid(ctx.m_inputs));
+    std::lock_guard lock(*m_mutex);
+    if (!ctx.cancelled()) m_costs.record(type_name(n), cells, ctx.m_spent_us);  // partial runs would skew it
+    if (!ok) {
+        if (!ctx.cancelled()) m_node_stats[node_id] = { node_stats::outcome::failed, ctx.m_spent_us };
+        return false; // Evaluation failed, skip
+    }
+
+    // Store outputs in cache
+    m_node_stats[node_id] = { node_stats::outcome::evaluated, ctx.m_spent_us, grid_bytes(ctx.m_outputs) };
+    m_cells[node_id] = cells;
+    m_cache[node_id].outputs = std::move(ctx.m_outputs);
+    return true;
 }
 
 void eval_engine::invalidate_all() {
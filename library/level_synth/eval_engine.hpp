@@ -1,12 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "pin.hpp"
+#include "cancel_token.hpp"
+#include "cost_model.hpp"
 #include "eval_context.hpp"
 #include "node_graph.hpp"
 
@@ -16,19 +26,282 @@ class node;
 
 class eval_engine {
 public:
+    eval_engine();
+    ~eval_engine();
+    eval_engine(eval_engine&&) noexcept;
+    eval_engine& operator=(eval_engine&&) noexcept;
+
     void evaluate(node_graph& graph, int master_seed = 0);
+
+    /// How far an evaluation has got; readable from other threads.
+    struct progress {
+        std::atomic<int> completed{ 0 };    // nodes done, including reused ones
+        std::atomic<int> total{ 0 };        // nodes in the graph
+    };
+
+    /// evaluate() that gives up once `cancel` fires: between nodes, and
+    /// inside nodes that poll eval_context::cancelled(). Returns false if
+    /// cancelled. Nodes that finished keep their outputs, so the next
+    /// evaluation picks up from there. Updates `progress` if given.
+    bool evaluate(node_graph& graph, int master_seed, const cancel_token& cancel, progress* p = nullptr);
+
+    /// Start evaluating `graph` a slice at a time on the calling thread,
+    /// for targets that can't spare a worker; step() does the work. The
+    /// graph must not change until step() returns true. Any evaluation
+    /// started later abandons this one.
+    void begin_steps(node_graph& graph, int master_seed = 0);
+
+    /// Work on the evaluation from begin_steps() until about `budget_us`
+    /// microseconds have passed, stopping between nodes or inside nodes
+    /// that check eval_context::should_yield(). Does at least one node or
+    /// slice per call. Returns true once every node has run (or if no
+    /// evaluation is in progress).
+    bool step(double budget_us);
+
+    bool stepping() const { return m_step != nullptr; }
+
+    struct step_stats {
+        int frames = 0;         // step() calls
+        double busy_us = 0;     // time spent inside them
+    };
+
+    /// How the last stepped evaluation to finish was spread over frames.
+    const step_stats& last_step_stats() const { return m_step_stats; }
+
+    /// Evaluate the cells in `region` of an unbounded world, for streaming
+    /// it in chunks. Grid outputs of nodes nothing reads from cover exactly
+    /// `region`. Every other node's grid covers the region its consumers
+    /// read, padded by their stencil_reach(). Nodes without grid inputs
+    /// (node_create_grid) size their grids by ctx.region(). Random cells
+    /// come from ctx.cell_random(), so adjacent regions join without
+    /// seams. Throws std::runtime_error if a node between a source and an
+    /// output has unknown reach.
+    void evaluate_region(node_graph& graph, const rect& region, int master_seed = 0);
+
+    /// Divisors of the grid resolution evaluate_progressive() steps through.
+    static constexpr int k_preview_divisors[] = { 4, 2, 1 };
+
+    /// Called with the engine holding a finished level's outputs and the
+    /// level's divisor (1 for full resolution).
+    using level_callback = std::function<void(const eval_engine& level, int divisor)>;
+
+    /// Evaluate at 1/4, then 1/2, then full resolution, calling `on_level`
+    /// as each level completes, so a coarse result shows up early. Grids
+    /// from node_create_grid shrink by the divisor, and nodes scale their
+    /// lengths with eval_context::spatial(). Each coarse level has its own
+    /// engine (see preview()) with its own cache; full resolution runs on
+    /// this engine. Stops between nodes once `cancel` fires and returns
+    /// false; levels delivered so far stay valid.
+    bool evaluate_progressive(node_graph& graph, int master_seed, const level_callback& on_level,
+                              const cancel_token& cancel = {});
+
+    /// The engine holding outputs at 1/divisor resolution: this engine for
+    /// 1, nullptr for a divisor evaluate_progressive() hasn't run.
+    const eval_engine* preview(int divisor) const;
+
+    /// Evaluate one node from the cached outputs of its upstream nodes and
+    /// cache its outputs. Returns false if the node is missing or its
+    /// evaluate() failed. Lets callers run a subset of the graph in their
+    /// own order (the graph optimizer folds constants this way).
+    bool evaluate_node(node_graph& graph, int node_id, int master_seed = 0);
+
     const pin_value* get_output(int node_id, const std::string& pin_name) const;
+
+    /// Drop all cached outputs, so the next evaluate() runs every node.
     void invalidate_all();
 
-private:
+    /// Nodes whose outputs the last evaluate() kept from the one before,
+    /// because neither they nor anything upstream changed. Only pure nodes
+    /// (node_flag_pure) are kept; nodes without the RNG flag are kept across
+    /// seed changes too.
+    int reused_count() const { return m_reused_count; }
+
+    /// Evaluate structurally identical nodes once (common subexpression
+    /// elimination). Two nodes are identical if they have the same type,
+    /// the same accept() state apart from name and position, and their
+    /// inputs come from identical nodes; see node::is_mergeable. Outputs
+    /// of an identical node from the previous evaluate() count too. On by
+    /// default.
+    void set_merge_identical(bool merge) { m_merge_identical = merge; }
+
+    /// Hash that buckets node keys, the identities behind both merging and
+    /// reuse. Keys whose hashes match are compared in full before any
+    /// outputs are shared, so the hash only affects speed. FNV-1a by default.
+    using key_hash = std::function<uint64_t(std::string_view)>;
+    void set_key_hash(key_hash hash);
+
+    /// Nodes that reused an identical node's outputs in the last evaluate().
+    int merged_count() const { return m_merged_count; }
+
+    /// Run chains of pointwise nodes (node_descriptor::pointwise) as one
+    /// pass that writes only the last node's grid. Intermediate nodes of a
+    /// chain have no cached outputs. On by default.
+    void set_fuse_pointwise(bool fuse) { m_fuse_pointwise = fuse; }
+
+    /// Pointwise nodes whose output grid was never written in the last
+    /// evaluate() because the next node consumed it in the same pass.
+    int fused_count() const { return m_fused_count; }
+
+    /// What the last evaluate() did with one node.
+    struct node_stats {
+        enum class outcome {
+            evaluated,  // ran evaluate(), or ran the fused pass ending at it
+            reused,     // kept its outputs from the evaluation before
+            merged,     // shared an identical node's outputs
+            fused,      // folded into the next node's pass, so no outputs
+            failed,     // evaluate() returned false
+        };
+        outcome result = outcome::evaluated;
+        double us = 0;              // wall time of its evaluate() or fused pass
+        size_t output_bytes = 0;    // of the grids in its outputs
+    };
+
+    /// Per node id, for every node the last evaluate() got to. Reused and
+    /// merged nodes took no time (us is 0) but still hold their outputs.
+    /// A node that yields (see step()) adds up its time over the slices.
+    const std::unordered_map<int, node_stats>& last_node_stats() const { return m_node_stats; }
+
+    /// Node ids in dependency order. Throws std::runtime_error on cycles.
     std::vector<int> topological_sort(const node_graph& graph) const;
+
+    /// Threads evaluate() runs nodes on, counting the calling thread. 1 (the
+    /// default) runs everything in order on the calling thread, 0 uses one
+    /// per hardware thread. Nodes without node_flag_thread_safe never run
+    /// at the same time as each other. Ready nodes start in order of the
+    /// longest estimated chain of work they lead to, so long chains aren't
+    /// left until the end.
+    void set_threads(int threads) { m_threads = threads; }
+    int threads() const { return m_threads; }
+
+    /// Measured evaluation times by node type and grid size, updated by
+    /// every evaluate(). Drives scheduling and the estimates below.
+    const cost_model& costs() const { return m_costs; }
+    cost_model& costs() { return m_costs; }
+
+    /// Assumed time for node types costs() has never measured.
+    static constexpr double k_default_cost_us = 10;
+
+    /// Predicted microseconds to evaluate one node from scratch, at the grid
+    /// size it had in the last evaluate() (or its inputs' sizes if it has
+    /// never run).
+    double estimate_node_us(const node_graph& graph, int node_id) const;
+
+    struct time_estimate {
+        double total_us = 0;            // every node, one after another
+        double critical_path_us = 0;    // the longest dependency chain
+
+        /// Lower bound on the time with `threads` threads.
+        double wall_us(int threads) const {
+            return std::max(critical_path_us, total_us / std::max(threads, 1));
+        }
+    };
+
+    /// Predicts how long evaluating `graph` from scratch takes, without
+    /// running it. Throws std::runtime_error on cycles.
+    time_estimate estimate_time(const node_graph& graph) const;
+
+private:
+    // What an evaluation has to do after reusing and merging what it can.
+    struct run_plan {
+        int nodes = 0;
+        std::vector<int> to_run;                                // dependency order
+        std::unordered_map<int, int> reps;                      // identical node to share outputs with
+        std::unordered_map<int, std::optional<uint64_t>> keys;
+
+        int rep_of(int id) const {
+            auto it = reps.find(id);
+            return it != reps.end() ? it->second : id;
+        }
+    };
+    run_plan plan_run(node_graph& graph, int master_seed);
+
+    // Returns false if `cancel` fired before every node ran.
+    bool run(node_graph& graph, int master_seed, const cancel_token* cancel = nullptr, progress* p = nullptr);
+
+    // World cells of a node's outputs, and of its grid inputs (`out`
+    // padded by the node's reach).
+    struct region_plan {
+        rect out;
+        rect in;
+    };
+    std::unordered_map<int, region_plan> plan_regions(node_graph& graph, const rect& region, int master_seed) const;
+
+    std::optional<uint64_t> node_key(const node_graph& graph, int node_id, node& n, int master_seed,
+                                     const std::unordered_map<int, std::optional<uint64_t>>& keys);
     eval_context build_context(const node_graph& graph, int node_id, int master_seed) const;
 
+    // Kernels of consecutive pointwise nodes, applied row by row to
+    // `source` when the chain ends.
+    struct pointwise_chain {
+        std::shared_ptr<grid> source;
+        std::vector<row_kernel> kernels;
+        std::vector<std::string> types;     // node type per kernel, for m_costs
+        std::string output;         // pointwise output pin of the last node
+    };
+
+    // Evaluates a node that wasn't reused: shares `rep`'s outputs if it
+    // has any, else runs fused or on its own.
+    void run_node(node_graph& graph, int node_id, int rep, std::optional<uint64_t> key, int master_seed);
+    bool run_parallel(node_graph& graph, const run_plan& plan, int master_seed, int threads);
+    bool finish_node(node& n, int node_id, eval_context& ctx);
+    std::unordered_map<int, size_t> estimate_cells(const node_graph& graph, const std::vector<int>& order) const;
+    double predict_us(const node& n, size_t cells) const;
+
+    bool evaluate_fused(node_graph& graph, int node_id, node& n, int master_seed);
+    bool ends_chain(const node_graph& graph, int node_id, const node& n) const;
+    void materialize(int node_id);
+    static std::shared_ptr<grid> run_chain(const pointwise_chain& chain);
+    void record_chain(const pointwise_chain& chain, size_t cells, double us);
+
     struct node_cache {
         std::unordered_map<std::string, pin_value> outputs;
+        std::optional<uint64_t> key;    // see node_key; empty if not reusable
+    };
+
+    // Guards m_cache, m_deferred, the counters and m_costs while nodes run
+    // on several threads. Heap-allocated to keep the engine movable.
+    std::unique_ptr<std::mutex> m_mutex;
+    // Held by nodes without node_flag_thread_safe while they run.
+    std::unique_ptr<std::mutex> m_exclusive;
+
+    // Node key encodings (see node_key) to the ids that stand for them.
+    struct key_bucket {
+        key_hash hash;
+        size_t operator()(const std::string& encoding) const { return size_t(hash(encoding)); }
     };
+    using key_table = std::unordered_map<std::string, uint64_t, key_bucket>;
+    key_table m_key_ids;
+    uint64_t m_next_key_id = 1;
 
     std::unordered_map<int, node_cache> m_cache;
+    std::unordered_map<int, pointwise_chain> m_deferred;    // by last node id
+    std::unordered_map<int, size_t> m_cells;                // largest grid per node, last run
+    std::unordered_map<int, node_stats> m_node_stats;       // last run
+    std::unordered_map<int, region_plan> m_regions;         // by node id; empty for whole graphs
+    std::map<int, std::unique_ptr<eval_engine>> m_previews; // by divisor
+    int m_divisor = 1;                                      // resolution is 1 / m_divisor
+    const cancel_token* m_cancel = nullptr;                 // during run()
+    progress* m_progress = nullptr;                         // during run()
+
+    struct step_state {
+        node_graph* graph = nullptr;
+        int seed = 0;
+        run_plan plan;
+        size_t next = 0;                        // index into plan.to_run
+        std::optional<eval_context> suspended;  // of plan.to_run[next]
+        step_stats stats;
+    };
+    std::unique_ptr<step_state> m_step;
+    step_stats m_step_stats;
+    std::optional<std::chrono::steady_clock::time_point> m_deadline;   // during step()
+    cost_model m_costs;
+    int  m_threads = 1;
+    bool m_parallel = false;                                // inside a multi-threaded evaluate()
+    bool m_merge_identical = true;
+    bool m_fuse_pointwise = true;
+    int  m_merged_count = 0;
+    int  m_fused_count = 0;
+    int  m_reused_count = 0;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ls {
+
+// Open-addressing hash table keyed by a non-zero 64-bit integer (raw tag
+// bits, segment hashes). Keys and values live in one flat array probed
+// linearly, so a lookup is a multiply, a shift and usually one cache line;
+// no per-entry allocation, no string hashing.
+//
+// Key 0 marks an empty slot and cannot be stored. That is free for the
+// registry: segment hashes are never 0 and the all-zero tag is a sentinel
+// that is never registered. Erase uses backward-shift deletion, so there
+// are no tombstones and probe chains stay short after removals.
+template <typename V>
+class flat_map {
+public:
+    flat_map() = default;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    V* find(uint64_t key) {
+        if (m_size == 0 || key == 0) return nullptr;
+        for (size_t i = home(key);; i = next(i)) {
+            if (m_slots[i].key == key) return &m_slots[i].value;
+            if (m_slots[i].key == 0) return nullptr;
+        }
+    }
+
+    const V* find(uint64_t key) const { return const_cast<flat_map*>(this)->find(key); }
+
+    bool contains(uint64_t key) const { return find(key) != nullptr; }
+
+    // Insert `value` under `key` unless the key is already present. Returns
+    // the stored value and whether it was inserted.
+    template <typename... Args>
+    std::pair<V*, bool> try_emplace(uint64_t key, Args&&... args) {
+        assert(key != 0 && "flat_map: key 0 is reserved for empty slots");
+        if (V* v = find(key)) return { v, false };
+        if ((m_size + 1) * 4 > m_slots.size() * 3)
+            rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+        size_t i = home(key);
+        while (m_slots[i].key != 0) i = next(i);
+        m_slots[i].key = key;
+        m_slots[i].value = V(std::forward<Args>(args)...);
+        ++m_size;
+        return { &m_slots[i].value, true };
+    }
+
+    V& operator[](uint64_t key) { return *try_emplace(key).first; }
+
+    bool erase(uint64_t key) {
+        if (m_size == 0 || key == 0) return false;
+        size_t i = home(key);
+        while (m_slots[i].key != key) {
+            if (m_slots[i].key == 0) return false;
+            i = next(i);
+        }
+        // Pull later entries of the probe chain back into the hole so that
+        // lookups never have to step over deleted slots.
+        for (size_t j = next(i);; j = next(j)) {
+            if (m_slots[j].key == 0) break;
+            const size_t h = home(m_slots[j].key);
+            // Move j into the hole unless its home lies cyclically in (i, j].
+            const bool stays = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+            if (stays) continue;
+            m_slots[i] = std::move(m_slots[j]);
+            i = j;
+        }
+        m_slots[i].key = 0;
+        m_slots[i].value = V();
+        --m_size;
+        return true;
+    }
+
+    void clear() {
+        m_slots.clear();
+        m_size = 0;
+    }
+
+    // Calls fn(key, value) for every entry, in table order.
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const auto& s : m_slots)
+            if (s.key != 0) fn(s.key, s.value);
+    }
+
+private:
+    struct slot {
+        uint64_t key = 0;
+        V        value{};
+    };
+
+    // Fibonacci hashing. Raw tags keep most of their entropy in the high
+    // bits (L2 is often 0), so the multiply is needed to spread them.
+    size_t home(uint64_t key) const {
+        return size_t((key * 0x9e3779b97f4a7c15ull) >> m_shift);
+    }
+
+    size_t next(size_t i) const { return (i + 1) & (m_slots.size() - 1); }
+
+    void rehash(size_t capacity) {
+        std::vector<slot> old = std::move(m_slots);
+        m_slots.assign(capacity, slot{});
+        m_shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) --m_shift;
+        for (auto& s : old) {
+            if (s.key == 0) continue;
+            size_t i = home(s.key);
+            while (m_slots[i].key != 0) i = next(i);
+            m_slots[i] = std::move(s);
+        }
+    }
+
+    std::vector<slot> m_slots;
+    size_t m_size = 0;
+    int m_shift = 64;
+};
+
+}
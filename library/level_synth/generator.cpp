@@ -4,10 +4,46 @@
 #include "nodes/node_output_grid.hpp"
 #include "nodes/node_output_number.hpp"
 
+#include <chrono>
 #include <stdexcept>
 
 namespace ls {
 
+evaluation& evaluation::operator=(evaluation&& other) noexcept {
+    if (this != &other) {
+        stop();
+        m_state = std::move(other.m_state);
+    }
+    return *this;
+}
+
+evaluation::~evaluation() {
+    stop();
+}
+
+void evaluation::stop() {
+    if (!m_state || !m_state->result.valid()) return;
+    m_state->cancel.cancel();
+    m_state->result.wait();
+}
+
+void evaluation::cancel() {
+    if (m_state) m_state->cancel.cancel();
+}
+
+bool evaluation::ready() const {
+    return !m_state || !m_state->result.valid()
+        || m_state->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool evaluation::wait() {
+    if (!m_state || !m_state->result.valid()) return false;
+    return m_state->result.get();
+}
+
+int evaluation::completed() const { return m_state ? m_state->progress.completed.load() : 0; }
+int evaluation::total() const { return m_state ? m_state->progress.total.load() : 0; }
+
 generator::generator() {}
 
 generator::~generator() = default;
@@ -33,12 +69,38 @@ void generator::evaluate() {
     m_engine.evaluate(m_graph, m_seed);
 }
 
-std::shared_ptr<grid> generator::get_grid_output(const std::string& name) const {
+evaluation generator::evaluate_async() {
+    evaluation e;
+    e.m_state = std::make_unique<evaluation::state>();
+    auto* s = e.m_state.get();
+    s->result = std::async(std::launch::async, [this, s] {
+        return m_engine.evaluate(m_graph, m_seed, s->cancel, &s->progress);
+    }).share();
+    return e;
+}
+
+bool generator::step(double budget_us) {
+    if (!m_engine.stepping()) m_engine.begin_steps(m_graph, m_seed);
+    return m_engine.step(budget_us);
+}
+
+void generator::evaluate_region(const rect& region) {
+    m_engine.evaluate_region(m_graph, region, m_seed);
+}
+
+bool generator::evaluate_progressive(const std::function<void(int divisor)>& on_level, const cancel_token& cancel) {
+    return m_engine.evaluate_progressive(m_graph, m_seed,
+        [&](const eval_engine&, int divisor) { if (on_level) on_level(divisor); }, cancel);
+}
+
+std::shared_ptr<grid> generator::get_grid_output(const std::string& name, int divisor) const {
     auto it = m_output_nodes.find(name);
     if (it == m_output_nodes.end())
         throw std::runtime_error("Unknown output: " + name);
 
-    auto* val = m_engine.get_output(it->second, "value");
+    const eval_engine* level = m_engine.preview(divisor);
+    if (!level) return nullptr;
+    auto* val = level->get_output(it->second, "value");
     if (!val) return nullptr;
 
     return std::get<std::shared_ptr<grid>>(*val);
@@ -73,4 +135,11 @@ void generator::rebuild_bindings() {
     }
 }
 
+optimize_report generator::optimize(const optimize_options& options) {
+    auto report = optimize_graph(m_graph, options);
+    m_engine.invalidate_all();
+    rebuild_bindings();
+    return report;
+}
+
 } // namespace ls
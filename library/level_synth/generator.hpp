@@ -1,16 +1,57 @@
 #pragma once
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
 
 #include "node_graph.hpp"
 #include "eval_engine.hpp"
+#include "graph_optimizer.hpp"
 
 namespace ls {
 
 class eval_engine;
 
+/// Handle to an evaluation running on a background thread
+/// (generator::evaluate_async). Destroying it cancels the evaluation and
+/// waits for it to stop.
+class evaluation {
+public:
+    evaluation() = default;
+    evaluation(evaluation&&) noexcept = default;
+    evaluation& operator=(evaluation&& other) noexcept;
+    ~evaluation();
+
+    /// Asks the evaluation to stop at the next node boundary, or sooner in
+    /// nodes that poll eval_context::cancelled().
+    void cancel();
+
+    /// True once the evaluation has finished, been cancelled or failed.
+    bool ready() const;
+
+    /// Blocks until ready(). Returns true if every node ran, false if
+    /// cancelled; rethrows anything the evaluation threw.
+    bool wait();
+
+    /// Nodes done so far, and in the graph.
+    int completed() const;
+    int total() const;
+
+private:
+    friend class generator;
+
+    void stop();
+
+    struct state {
+        cancel_token cancel;
+        eval_engine::progress progress;
+        std::shared_future<bool> result;
+    };
+    std::unique_ptr<state> m_state;
+};
+
 class generator {
 public:
     generator();
@@ -21,10 +62,36 @@ public:
     void set_seed(int seed) { m_seed = seed; }
     int  seed()       const { return m_seed; }
     void evaluate();
-    std::shared_ptr<grid> get_grid_output(const std::string& name) const;
+
+    /// Run evaluate() on a background thread. Until the returned evaluation
+    /// is ready, the generator (graph, parameters, outputs) must be left
+    /// alone; once it is, outputs read as after evaluate(). A cancelled
+    /// evaluation keeps what it finished, and the next one reuses it.
+    evaluation evaluate_async();
+
+    /// Advance a generation on the calling thread for about `budget_us`
+    /// microseconds, starting one if none is in progress. Returns true once
+    /// it has finished; outputs then read as after evaluate(). Meant to be
+    /// called once per frame; see eval_engine::step and last_step_stats.
+    bool step(double budget_us);
+
+    /// Evaluate only the cells in `region` of an unbounded world; grid
+    /// outputs then cover exactly `region`. See eval_engine::evaluate_region.
+    void evaluate_region(const rect& region);
+
+    /// Evaluate at 1/4, 1/2 and then full resolution, calling `on_level`
+    /// with each finished level's divisor; get_grid_output(name, divisor)
+    /// reads that level. Returns false if `cancel` fired first. See
+    /// eval_engine::evaluate_progressive.
+    bool evaluate_progressive(const std::function<void(int divisor)>& on_level, const cancel_token& cancel = {});
+    std::shared_ptr<grid> get_grid_output(const std::string& name, int divisor = 1) const;
     double get_number_output(const std::string& name) const;
     void rebuild_bindings();
 
+    /// Run optimize_graph on the graph and rebind parameters and outputs.
+    /// For graphs loaded to be run, not for one that is being edited.
+    optimize_report optimize(const optimize_options& options = {});
+
     eval_engine& engine() { return m_engine; }
     node_graph& graph() { return m_graph; }
     const node_graph& graph() const { return m_graph; }
@@ -0,0 +1,209 @@
+#include "graph_delta.hpp"
+#include "node_registry.hpp"
+#include "node_visitor.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace ls {
+
+namespace {
+
+// Records every visited member in visit order.
+class field_recorder final : public node_visitor {
+public:
+    explicit field_recorder(std::vector<node_field>& out) : m_out(out) {}
+
+    void visit(std::string_view name, double& v) override      { add(name, v); }
+    void visit(std::string_view name, int& v) override         { add(name, v); }
+    void visit(std::string_view name, vec2& v) override        { add(name, v); }
+    void visit(std::string_view name, std::string& v) override { add(name, v); }
+    void visit(std::string_view name, tag& t) override         { add(name, t); }
+
+private:
+    template <typename T>
+    void add(std::string_view name, const T& v) { m_out.push_back({ std::string(name), v }); }
+
+    std::vector<node_field>& m_out;
+};
+
+// Assigns members from a list of (name, value) pairs. Members that aren't
+// listed, or are listed with a different type, are left alone.
+template <typename Field, typename Get>
+class field_writer final : public node_visitor {
+public:
+    field_writer(const std::vector<Field>& fields, Get get) : m_fields(fields), m_get(get) {}
+
+    void visit(std::string_view name, double& v) override      { set(name, v); }
+    void visit(std::string_view name, int& v) override         { set(name, v); }
+    void visit(std::string_view name, vec2& v) override        { set(name, v); }
+    void visit(std::string_view name, std::string& v) override { set(name, v); }
+    void visit(std::string_view name, tag& t) override         { set(name, t); }
+
+private:
+    template <typename T>
+    void set(std::string_view name, T& dst) {
+        for (const auto& f : m_fields) {
+            if (f.name != name) continue;
+            if (const T* v = std::get_if<T>(&m_get(f))) dst = *v;
+            return;
+        }
+    }
+
+    const std::vector<Field>& m_fields;
+    Get m_get;
+};
+
+template <typename Field, typename Get>
+void write_fields(node& n, const std::vector<Field>& fields, Get get) {
+    field_writer<Field, Get> w(fields, get);
+    n.accept(w);
+}
+
+size_t value_bytes(const field_value& v) {
+    const auto* s = std::get_if<std::string>(&v);
+    return sizeof(field_value) + (s ? s->capacity() : 0);
+}
+
+size_t state_bytes(const node_state& s) {
+    size_t n = sizeof(node_state) + s.type.capacity();
+    for (const auto& f : s.fields) n += f.name.capacity() + value_bytes(f.value);
+    return n;
+}
+
+size_t wire_bytes(const wire& w) {
+    return sizeof(wire) + w.from_pin.capacity() + w.to_pin.capacity();
+}
+
+struct wire_hash {
+    size_t operator()(const wire& w) const {
+        size_t h = std::hash<int>{}(w.from_node);
+        for (size_t v : { std::hash<std::string>{}(w.from_pin), std::hash<int>{}(w.to_node),
+                          std::hash<std::string>{}(w.to_pin) })
+            h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// Wires of `from` that aren't in `to`, with their indices in `from`.
+std::vector<std::pair<size_t, wire>> missing_wires(const std::vector<wire>& from, const std::vector<wire>& to) {
+    const std::unordered_set<wire, wire_hash> present(to.begin(), to.end());
+    std::vector<std::pair<size_t, wire>> out;
+    for (size_t i = 0; i < from.size(); ++i)
+        if (!present.contains(from[i])) out.emplace_back(i, from[i]);
+    return out;
+}
+
+} // anonymous namespace
+
+graph_state graph_state::capture(const node_graph& g) {
+    auto& reg = node_registry::instance();
+    graph_state s;
+    for (int id : g.node_ids()) {
+        node* n = const_cast<node*>(g.find_node(id));
+        const auto* entry = reg.find(*n);
+        node_state& ns = s.nodes[id];
+        ns.type = entry ? entry->type_name : std::string();
+        field_recorder rec(ns.fields);
+        n->accept(rec);
+        if (n->has_opaque_state()) s.opaque.emplace(id, n->save_state());
+    }
+    s.wires = g.wires();
+    return s;
+}
+
+graph_delta graph_delta::diff(const graph_state& before, const graph_state& after) {
+    graph_delta d;
+
+    for (const auto& [id, b] : before.nodes) {
+        auto it = after.nodes.find(id);
+        // A node whose type changed under the same id is a remove + add.
+        if (it == after.nodes.end() || it->second.type != b.type) {
+            d.m_removed.emplace_back(id, b);
+            if (it != after.nodes.end()) d.m_added.emplace_back(id, it->second);
+            continue;
+        }
+
+        const node_state& a = it->second;
+        node_change c{ id, {} };
+        for (const auto& fb : b.fields) {
+            auto fa = std::find_if(a.fields.begin(), a.fields.end(),
+                                   [&](const node_field& f) { return f.name == fb.name; });
+            if (fa != a.fields.end() && !(fa->value == fb.value))
+                c.fields.push_back({ fb.name, fb.value, fa->value });
+        }
+        if (!c.fields.empty()) d.m_changed.push_back(std::move(c));
+    }
+
+    for (const auto& [id, a] : after.nodes)
+        if (!before.nodes.contains(id)) d.m_added.emplace_back(id, a);
+
+    d.m_wires_removed = missing_wires(before.wires, after.wires);
+    d.m_wires_added   = missing_wires(after.wires, before.wires);
+
+    return d;
+}
+
+bool graph_delta::empty() const {
+    return m_changed.empty() && m_added.empty() && m_removed.empty()
+        && m_wires_added.empty() && m_wires_removed.empty();
+}
+
+void graph_delta::apply(node_graph& g, const node_change& c, bool forward) {
+    node* n = g.find_node(c.id);
+    if (!n) throw std::runtime_error("graph_delta: node " + std::to_string(c.id) + " is missing");
+    write_fields(*n, c.fields, [forward](const field_change& f) -> const field_value& {
+        return forward ? f.after : f.before;
+    });
+}
+
+void graph_delta::restore(node_graph& g, int id, const node_state& s) {
+    auto n = node_registry::instance().create(s.type);
+    write_fields(*n, s.fields, [](const node_field& f) -> const field_value& { return f.value; });
+    g.insert_node(id, std::move(n));
+}
+
+void graph_delta::undo(node_graph& g) const {
+    for (const auto& [_, w] : m_wires_added)
+        g.remove_wire(w.from_node, w.from_pin, w.to_node, w.to_pin);
+    for (const auto& [id, _] : m_added)
+        g.remove_node(id);
+    for (const auto& [id, s] : m_removed)
+        restore(g, id, s);
+    for (const auto& c : m_changed)
+        apply(g, c, false);
+    // In ascending index order, so each lands where it was.
+    for (const auto& [index, w] : m_wires_removed)
+        g.insert_wire(index, w);
+}
+
+void graph_delta::redo(node_graph& g) const {
+    for (const auto& [_, w] : m_wires_removed)
+        g.remove_wire(w.from_node, w.from_pin, w.to_node, w.to_pin);
+    for (const auto& [id, _] : m_removed)
+        g.remove_node(id);
+    for (const auto& [id, s] : m_added)
+        restore(g, id, s);
+    for (const auto& c : m_changed)
+        apply(g, c, true);
+    for (const auto& [index, w] : m_wires_added)
+        g.insert_wire(index, w);
+}
+
+size_t graph_delta::bytes() const {
+    size_t n = sizeof(graph_delta);
+    for (const auto& c : m_changed) {
+        n += sizeof(node_change);
+        for (const auto& f : c.fields)
+            n += sizeof(field_change) + f.name.capacity() + value_bytes(f.before) + value_bytes(f.after);
+    }
+    for (const auto& [_, s] : m_added)   n += state_bytes(s);
+    for (const auto& [_, s] : m_removed) n += state_bytes(s);
+    for (const auto& [_, w] : m_wires_added)   n += wire_bytes(w) + sizeof(size_t);
+    for (const auto& [_, w] : m_wires_removed) n += wire_bytes(w) + sizeof(size_t);
+    return n;
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "node_graph.hpp"
+#include "tag.hpp"
+#include "vec2.hpp"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace ls {
+
+/// Value of one persistent node member, as seen through accept().
+using field_value = std::variant<double, int, vec2, std::string, tag>;
+
+struct node_field {
+    std::string name;
+    field_value value;
+};
+
+/// Everything accept() exposes about one node, plus its type.
+struct node_state {
+    std::string type;
+    std::vector<node_field> fields;
+};
+
+/// Structural copy of a graph: node states by id and the wires.
+/// Cheaper than a JSON snapshot to take and to compare, and the input to
+/// graph_delta::diff.
+struct graph_state {
+    std::map<int, node_state> nodes;
+    std::vector<wire> wires;
+
+    /// node::save_state() of each node with has_opaque_state(), by id.
+    std::map<int, std::string> opaque;
+
+    static graph_state capture(const node_graph& g);
+};
+
+/// The difference between two graph states, applied in place.
+///
+/// Holds only what changed: the fields that differ on surviving nodes, the
+/// full state of added or removed nodes, and added or removed wires. Undo
+/// and redo touch exactly those nodes and wires instead of reloading the
+/// graph, so a node drag costs a few bytes of history rather than two
+/// copies of the document.
+///
+/// Node state that accept() does not visit is invisible to the delta; the
+/// editor keeps per-node save_state() snapshots alongside it for that case.
+class graph_delta {
+public:
+    static graph_delta diff(const graph_state& before, const graph_state& after);
+
+    bool empty() const;
+
+    /// Turn a graph in the "after" state back into the "before" state.
+    void undo(node_graph& g) const;
+
+    /// Turn a graph in the "before" state into the "after" state.
+    void redo(node_graph& g) const;
+
+    /// Approximate heap and inline memory held by this delta.
+    size_t bytes() const;
+
+private:
+    struct field_change {
+        std::string name;
+        field_value before;
+        field_value after;
+    };
+
+    struct node_change {
+        int id;
+        std::vector<field_change> fields;
+    };
+
+    static void apply(node_graph& g, const node_change& c, bool forward);
+    static void restore(node_graph& g, int id, const node_state& s);
+
+    std::vector<node_change> m_changed;
+    std::vector<std::pair<int, node_state>> m_added;
+    std::vector<std::pair<int, node_state>> m_removed;
+    // With their positions in the "after" and "before" wire lists, so undo
+    // and redo put them back in order.
+    std::vector<std::pair<size_t, wire>> m_wires_added;
+    std::vector<std::pair<size_t, wire>> m_wires_removed;
+};
+
+}
@@ -0,0 +1,136 @@
+#include "graph_optimizer.hpp"
+#include "eval_engine.hpp"
+#include "nodes/node_constant_number.hpp"
+#include "nodes/node_input_number.hpp"
+
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+#include <utility>
+
+namespace ls {
+
+namespace {
+
+bool has_output_pins(const node& n) {
+    const auto& pins = n.descriptor().pins;
+    return std::any_of(pins.begin(), pins.end(),
+                       [](const pin_descriptor& p) { return p.direction == pin_direction::output; });
+}
+
+bool number_only(const node& n) {
+    const auto& pins = n.descriptor().pins;
+    return std::all_of(pins.begin(), pins.end(),
+                       [](const pin_descriptor& p) { return p.type == pin_type::number; });
+}
+
+// Pure function of its inputs and members: same result for any seed or
+// parameter setting. Sinks stay, since the generator reads them by name.
+bool foldable(const node& n) {
+    return n.descriptor().has(node_flag_pure) && !n.is_stochastic()
+        && !dynamic_cast<const node_input_number*>(&n)
+        && number_only(n) && has_output_pins(n);
+}
+
+void fold_constants(node_graph& graph, optimize_report& report) {
+    eval_engine engine;
+    std::unordered_set<int> known;      // outputs are fixed: constants and folded nodes
+    std::unordered_set<int> folded;
+
+    for (int id : engine.topological_sort(graph)) {
+        node* n = graph.find_node(id);
+        const bool constant = dynamic_cast<const node_constant_number*>(n) != nullptr;
+        if (!constant && !foldable(*n)) continue;
+
+        const bool inputs_known = std::all_of(graph.wires().begin(), graph.wires().end(),
+            [&](const wire& w) { return w.to_node != id || known.contains(w.from_node); });
+        if (!inputs_known) continue;
+
+        bool ok = false;
+        try {
+            ok = engine.evaluate_node(graph, id);
+        } catch (const std::exception&) {
+        }
+        // Every output must have a value, or consumers would lose an input.
+        for (const auto& p : n->descriptor().pins)
+            if (p.direction == pin_direction::output && !engine.get_output(id, p.name)) ok = false;
+        if (!ok) continue;
+
+        known.insert(id);
+        if (!constant) folded.insert(id);
+    }
+
+    // One constant per folded output that something outside the folded set
+    // consumes.
+    std::map<std::pair<int, std::string>, int> constant_for;
+    std::vector<wire> rewired;
+    for (const auto& w : graph.wires()) {
+        if (!folded.contains(w.from_node) || folded.contains(w.to_node)) continue;
+
+        auto [it, inserted] = constant_for.try_emplace({ w.from_node, w.from_pin }, 0);
+        if (inserted) {
+            const node* src = graph.find_node(w.from_node);
+            auto c = std::make_unique<node_constant_number>();
+            c->set_value(std::get<double>(*engine.get_output(w.from_node, w.from_pin)));
+            c->set_position(src->position());
+            c->set_name(src->name());
+            it->second = graph.add_node(std::move(c));
+            report.constants.push_back(it->second);
+        }
+        rewired.push_back({ it->second, "value", w.to_node, w.to_pin });
+    }
+
+    for (int id : folded) graph.remove_node(id);
+    for (const auto& w : rewired) graph.add_wire(w);
+
+    report.folded.assign(folded.begin(), folded.end());
+    std::sort(report.folded.begin(), report.folded.end());
+}
+
+void remove_dead(node_graph& graph, optimize_report& report) {
+    std::vector<int> pending;
+    for (int id : graph.node_ids())
+        if (!has_output_pins(*graph.find_node(id))) pending.push_back(id);
+    // A graph without outputs is probably still being built; leave it.
+    if (pending.empty()) return;
+
+    std::unordered_set<int> live(pending.begin(), pending.end());
+    while (!pending.empty()) {
+        const int id = pending.back();
+        pending.pop_back();
+        for (const auto& w : graph.wires())
+            if (w.to_node == id && live.insert(w.from_node).second) pending.push_back(w.from_node);
+    }
+
+    for (int id : graph.node_ids()) {
+        if (live.contains(id) || dynamic_cast<const node_input_number*>(graph.find_node(id))) continue;
+        graph.remove_node(id);
+        report.removed.push_back(id);
+    }
+    std::sort(report.removed.begin(), report.removed.end());
+}
+
+std::string count(size_t n, const char* what) {
+    return std::to_string(n) + " " + what + (n == 1 ? "" : "s");
+}
+
+} // anonymous namespace
+
+std::string optimize_report::summary() const {
+    if (!changed()) return "nothing to optimize";
+    std::string s;
+    if (!folded.empty())
+        s = "folded " + count(folded.size(), "node") + " into " + count(constants.size(), "constant");
+    if (!removed.empty())
+        s += (s.empty() ? "removed " : ", removed ") + count(removed.size(), "unreachable node");
+    return s;
+}
+
+optimize_report optimize_graph(node_graph& graph, const optimize_options& options) {
+    optimize_report report;
+    if (options.fold_constants) fold_constants(graph, report);
+    if (options.remove_dead)    remove_dead(graph, report);
+    return report;
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "node_graph.hpp"
+
+#include <string>
+#include <vector>
+
+namespace ls {
+
+struct optimize_options {
+    /// Replace number-only subgraphs that don't depend on a parameter
+    /// (node_input_number) or on the seed with node_constant_number.
+    bool fold_constants = true;
+
+    /// Remove nodes that no output node depends on. Parameters are kept so
+    /// the generator's interface doesn't change.
+    bool remove_dead = true;
+};
+
+struct optimize_report {
+    std::vector<int> folded;        ///< nodes replaced by constants
+    std::vector<int> constants;     ///< constant nodes added for them
+    std::vector<int> removed;       ///< nodes unreachable from any output
+
+    bool changed() const { return !folded.empty() || !removed.empty(); }
+
+    /// One line for logs, e.g. "folded 3 nodes into 1 constant, removed 2
+    /// unreachable nodes".
+    std::string summary() const;
+};
+
+/// Simplify a graph before evaluation, in place. Outputs keep their values
+/// for every seed and parameter setting.
+///
+/// Meant for graphs that are about to be run rather than edited: the
+/// generator at load time (generator::optimize) or a bake step that ships
+/// the result (see samples/bake_graph.cpp). Folded nodes are evaluated
+/// once here, so a failing or throwing node is simply left in place.
+optimize_report optimize_graph(node_graph& graph, const optimize_options& options = {});
+
+}
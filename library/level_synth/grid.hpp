@@ -1,11 +1,41 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "tag.hpp"
+#include "tag_index.hpp"
 
 namespace ls {
 
+/// Summary of a grid's contents. Computed lazily by `grid::stats()` and
+/// cached until the grid is next mutated, so repeated readers (previews,
+/// downstream nodes) pay for the scan once.
+struct grid_stats {
+    /// Range of the numeric cells. Only meaningful when numeric_count > 0.
+    int64_t min_value = 0;
+    int64_t max_value = 0;
+    size_t  numeric_count = 0;
+
+    /// Cell count per distinct tag (symbolic and numeric), sorted by raw bits.
+    std::vector<std::pair<tag, size_t>> histogram;
+
+    /// Distinct symbolic tags present in the grid, sorted by raw bits.
+    std::vector<tag> symbolic_tags;
+
+    /// Number of cells holding exactly `t`.
+    size_t count(tag t) const {
+        auto it = std::lower_bound(histogram.begin(), histogram.end(), t.raw(),
+            [](const std::pair<tag, size_t>& e, uint64_t raw) { return e.first.raw() < raw; });
+        return (it != histogram.end() && it->first == t) ? it->second : 0;
+    }
+};
+
 class grid {
 public:
     grid(int width, int height)
@@ -15,32 +45,140 @@ public:
         : m_width(width), m_height(height), m_data(width * height, fill_value) {}
 
     grid(const grid& other)
-        : m_width(other.m_width), m_height(other.m_height), m_data(other.m_data) {}
+        : m_width(other.m_width), m_height(other.m_height), m_data(other.m_data),
+          m_stats(load(other.m_stats)), m_index(load(other.m_index)) {}
 
     ~grid() = default;
 
-    grid& operator=(const grid&) = default;
+    grid& operator=(const grid& other) {
+        m_width  = other.m_width;
+        m_height = other.m_height;
+        m_data   = other.m_data;
+        store(m_stats, load(other.m_stats));
+        store(m_index, load(other.m_index));
+        return *this;
+    }
 
     grid(grid&&) = default;
     grid& operator=(grid&&) = default;
 
     tag get(int x, int y) const { return m_data[y * m_width + x]; }
-    void set(int x, int y, tag value) { m_data[y * m_width + x] = value; }
+    void set(int x, int y, tag value) { invalidate(); m_data[y * m_width + x] = value; }
 
     bool in_bounds(int x, int y) const { return x >= 0 && x < m_width && y >= 0 && y < m_height; }
 
-    tag& operator()(int x, int y) { return m_data[y * m_width + x]; }
+    // The non-const accessor hands out a writable reference, so it has to
+    // assume the caller writes through it.
+    tag& operator()(int x, int y) { invalidate(); return m_data[y * m_width + x]; }
     tag operator()(int x, int y) const { return m_data[y * m_width + x]; }
 
-    void fill(tag value) { std::fill(m_data.begin(), m_data.end(), value); }
+    void fill(tag value) { invalidate(); std::fill(m_data.begin(), m_data.end(), value); }
 
     int width() const { return m_width; }
     int height() const { return m_height; }
 
+    /// Row-major cell storage (width * height entries).
+    const tag* data() const { return m_data.data(); }
+
+    /// Writable cell storage, for kernels that fill whole rows. Drops the
+    /// cached stats and index like any other mutation.
+    tag* mutable_data() { invalidate(); return m_data.data(); }
+
+    /// Cached summary statistics. The first call after a mutation scans the
+    /// grid once; later calls return the cached result. Safe to call from
+    /// several threads on a grid that is no longer being written.
+    const grid_stats& stats() const {
+        return cached(m_stats, [this] { return compute_stats(m_data.data(), m_data.size()); });
+    }
+
+    /// Bitmap index of the symbolic tags in the grid, built on first use and
+    /// cached like stats(). Worth it when the same grid is queried for
+    /// several tags; for a single query match_mask() is cheaper.
+    const tag_index& index() const {
+        return cached(m_index, [this] { return tag_index(m_data.data(), m_width, m_height); });
+    }
+
 private:
+    template <typename T>
+    static std::shared_ptr<const T> load(const std::shared_ptr<const T>& slot) {
+        return std::atomic_load_explicit(&slot, std::memory_order_acquire);
+    }
+
+    template <typename T>
+    static void store(std::shared_ptr<const T>& slot, std::shared_ptr<const T> value) {
+        std::atomic_store_explicit(&slot, std::move(value), std::memory_order_release);
+    }
+
+    // The grid keeps the cached object alive until the next mutation, which
+    // is also when a caller's reference to it stops being meaningful. If two
+    // readers race to build it, the first one stored wins so references that
+    // were already handed out stay valid.
+    template <typename T, typename Build>
+    static const T& cached(std::shared_ptr<const T>& slot, Build&& build) {
+        auto s = load(slot);
+        if (!s) {
+            std::shared_ptr<const T> expected;
+            s = std::make_shared<const T>(build());
+            if (!std::atomic_compare_exchange_strong(&slot, &expected, s))
+                s = std::move(expected);
+        }
+        return *s;
+    }
+
+    void invalidate() {
+        if (m_stats) store(m_stats, {});
+        if (m_index) store(m_index, {});
+    }
+
+    // One pass over the raw cells. Level grids are dominated by long runs of
+    // the same tag, so the loop only compares 64-bit words and touches the
+    // histogram once per run rather than once per cell.
+    static grid_stats compute_stats(const tag* cells, size_t n) {
+        grid_stats s;
+        std::unordered_map<uint64_t, size_t> counts;
+        int64_t lo = INT64_MAX;
+        int64_t hi = INT64_MIN;
+
+        size_t i = 0;
+        while (i < n) {
+            const uint64_t raw = cells[i].raw();
+            size_t j = i + 1;
+            while (j < n && cells[j].raw() == raw) ++j;
+            const size_t run = j - i;
+            i = j;
+
+            counts[raw] += run;
+            if (raw & tag::k_mode_bit) {
+                const int64_t v = tag(raw).value();
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+                s.numeric_count += run;
+            }
+        }
+
+        if (s.numeric_count > 0) {
+            s.min_value = lo;
+            s.max_value = hi;
+        }
+
+        s.histogram.reserve(counts.size());
+        for (const auto& [raw, count] : counts) {
+            s.histogram.emplace_back(tag(raw), count);
+            if (!(raw & tag::k_mode_bit))
+                s.symbolic_tags.push_back(tag(raw));
+        }
+        std::sort(s.histogram.begin(), s.histogram.end(),
+            [](const auto& a, const auto& b) { return a.first.raw() < b.first.raw(); });
+        std::sort(s.symbolic_tags.begin(), s.symbolic_tags.end(),
+            [](tag a, tag b) { return a.raw() < b.raw(); });
+        return s;
+    }
+
     int m_width = -1;
     int m_height = -1;
     std::vector<tag> m_data;
+    mutable std::shared_ptr<const grid_stats> m_stats;
+    mutable std::shared_ptr<const tag_index> m_index;
 };
 
 }
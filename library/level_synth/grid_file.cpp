@@ -0,0 +1,410 @@
+#include "grid_file.hpp"
+#include "binary_visitor.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ls {
+
+namespace {
+
+constexpr char     k_grid_magic[4]  = { 'L', 'S', 'G', 'R' };
+constexpr uint32_t k_grid_version   = 1;
+constexpr size_t   k_header_size    = 64;
+constexpr size_t   k_chunk_entry_size = 24;   // u64 offset, u64 size, u32 encoding, u32 pad
+
+size_t element_size(grid_storage s) {
+    switch (s) {
+        case grid_storage::palette8:  return 1;
+        case grid_storage::palette16: return 2;
+        default:                      return 8;
+    }
+}
+
+void put_element(byte_writer& out, grid_storage s, uint64_t v) {
+    switch (s) {
+        case grid_storage::palette8:  out.u8(uint8_t(v)); break;
+        case grid_storage::palette16: out.u16(uint16_t(v)); break;
+        default:                      out.u64(v); break;
+    }
+}
+
+void align8(byte_writer& out) {
+    while (out.size() % 8) out.u8(0);
+}
+
+// Header fields, in file order.
+struct header {
+    int32_t  width = 0;
+    int32_t  height = 0;
+    uint32_t storage = 0;
+    uint32_t compression = 0;
+    uint32_t chunk_rows = 0;
+    uint32_t palette_size = 0;
+    uint64_t palette_offset = 0;
+    uint64_t chunks_offset = 0;
+    uint64_t cells_offset = 0;
+};
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------------
+
+std::vector<uint8_t> encode_grid(const grid& g, const grid_file_options& options) {
+    const auto& hist = g.stats().histogram;       // sorted by raw bits
+
+    grid_storage storage = options.storage;
+    if (options.auto_storage) {
+        storage = hist.size() <= 0x100   ? grid_storage::palette8
+                : hist.size() <= 0x10000 ? grid_storage::palette16
+                                         : grid_storage::raw;
+    }
+    if ((storage == grid_storage::palette8  && hist.size() > 0x100) ||
+        (storage == grid_storage::palette16 && hist.size() > 0x10000))
+        throw std::runtime_error("Too many distinct tags for palette storage");
+
+    const bool paletted  = storage != grid_storage::raw;
+    const bool rle       = options.compression == grid_compression::rle;
+    const int chunk_rows = std::max(1, options.chunk_rows);
+    const int chunks     = rle ? (g.height() + chunk_rows - 1) / chunk_rows : 0;
+
+    // Value stored for a cell: its raw bits, or its palette index. Cells come
+    // in runs, so the palette search runs once per run.
+    auto element = [&](uint64_t raw) -> uint64_t {
+        if (!paletted) return raw;
+        auto it = std::lower_bound(hist.begin(), hist.end(), raw,
+            [](const auto& e, uint64_t r) { return e.first.raw() < r; });
+        return uint64_t(it - hist.begin());
+    };
+
+    byte_writer out;
+    out.bytes(k_grid_magic, 4);
+    out.u32(k_grid_version);
+    out.i32(g.width());
+    out.i32(g.height());
+    out.u32(uint32_t(storage));
+    out.u32(uint32_t(options.compression));
+    out.u32(uint32_t(chunk_rows));
+    out.u32(paletted ? uint32_t(hist.size()) : 0);
+    const size_t offsets_at = out.size();
+    out.u64(0);     // palette offset
+    out.u64(0);     // chunk table offset
+    out.u64(0);     // cells offset
+    while (out.size() < k_header_size) out.u8(0);
+
+    auto patch_u64 = [&](size_t at, uint64_t v) {
+        out.patch_u32(at, uint32_t(v));
+        out.patch_u32(at + 4, uint32_t(v >> 32));
+    };
+
+    if (paletted) {
+        patch_u64(offsets_at, out.size());
+        for (const auto& [t, _] : hist) out.u64(t.raw());
+    }
+
+    size_t table_at = 0;
+    if (rle) {
+        align8(out);
+        table_at = out.size();
+        patch_u64(offsets_at + 8, table_at);
+        for (int c = 0; c < chunks; ++c) { out.u64(0); out.u64(0); out.u32(0); out.u32(0); }
+    }
+
+    align8(out);
+    patch_u64(offsets_at + 16, out.size());
+
+    const tag* cells = g.data();
+    const size_t n = size_t(g.width()) * g.height();
+
+    // Cells [begin, end) as a flat element array.
+    auto put_cells = [&](byte_writer& to, size_t begin, size_t end) {
+        size_t i = begin;
+        while (i < end) {
+            const uint64_t raw = cells[i].raw();
+            size_t j = i + 1;
+            while (j < end && cells[j].raw() == raw) ++j;
+            const uint64_t e = element(raw);
+            for (; i < j; ++i) put_element(to, storage, e);
+        }
+    };
+
+    if (!rle) {
+        put_cells(out, 0, n);
+        return out.take();
+    }
+
+    // A compressed band is a sequence of (u32 run length, element) pairs.
+    // Bands that don't shrink that way stay flat, so they can be read in
+    // place like an uncompressed file.
+    const size_t elem = element_size(storage);
+    for (int c = 0; c < chunks; ++c) {
+        const size_t begin = size_t(c) * chunk_rows * g.width();
+        const size_t end   = std::min(n, begin + size_t(chunk_rows) * g.width());
+        byte_writer runs;
+        size_t i = begin;
+        while (i < end) {
+            const uint64_t raw = cells[i].raw();
+            size_t j = i + 1;
+            while (j < end && cells[j].raw() == raw && j - i < UINT32_MAX) ++j;
+            runs.u32(uint32_t(j - i));
+            put_element(runs, storage, element(raw));
+            i = j;
+        }
+
+        auto encoding = grid_compression::rle;
+        if (runs.size() >= (end - begin) * elem) {
+            encoding = grid_compression::none;
+            align8(out);
+        }
+        const size_t start = out.size();
+        if (encoding == grid_compression::rle) {
+            const auto bytes = runs.take();
+            out.bytes(bytes.data(), bytes.size());
+        } else {
+            put_cells(out, begin, end);
+        }
+        patch_u64(table_at + k_chunk_entry_size * c, start);
+        patch_u64(table_at + k_chunk_entry_size * c + 8, out.size() - start);
+        out.patch_u32(table_at + k_chunk_entry_size * c + 16, uint32_t(encoding));
+    }
+    return out.take();
+}
+
+void save_grid(const grid& g, const std::string& path, const grid_file_options& options) {
+    const auto bytes = encode_grid(g, options);
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) throw std::runtime_error("Cannot open for writing: " + path);
+    f.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+    if (!f) throw std::runtime_error("Failed writing: " + path);
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+
+grid grid_view::to_grid() const {
+    grid g(m_width, m_height);
+    for (int y = 0; y < m_height; ++y)
+        for (int x = 0; x < m_width; ++x)
+            g.set(x, y, get(x, y));
+    return g;
+}
+
+void grid_file::parse(const uint8_t* data, size_t size) {
+    byte_reader in(data, size);
+    if (size < k_header_size || std::memcmp(in.bytes(4), k_grid_magic, 4) != 0)
+        throw std::runtime_error("Not a level_synth grid file");
+    if (const uint32_t version = in.u32(); version != k_grid_version)
+        throw std::runtime_error("Unsupported grid file version " + std::to_string(version));
+
+    header h;
+    h.width          = in.i32();
+    h.height         = in.i32();
+    h.storage        = in.u32();
+    h.compression    = in.u32();
+    h.chunk_rows     = in.u32();
+    h.palette_size   = in.u32();
+    h.palette_offset = in.u64();
+    h.chunks_offset  = in.u64();
+    h.cells_offset   = in.u64();
+
+    if (h.width < 0 || h.height < 0 || h.storage > 2 || h.compression > 1 || h.chunk_rows == 0)
+        throw std::runtime_error("Corrupt grid file header");
+    if (uint64_t(h.width) * uint64_t(h.height) > (uint64_t(1) << 40))
+        throw std::runtime_error("Corrupt grid file: dimensions too large");
+
+    const auto storage = grid_storage(h.storage);
+    const size_t elem  = element_size(storage);
+    const size_t n     = size_t(h.width) * size_t(h.height);
+
+    auto check_range = [&](uint64_t offset, uint64_t bytes) {
+        if (offset > size || bytes > size - offset)
+            throw std::runtime_error("Corrupt grid file: section out of range");
+    };
+
+    const uint8_t* palette = nullptr;
+    if (storage != grid_storage::raw) {
+        check_range(h.palette_offset, uint64_t(h.palette_size) * 8);
+        palette = data + h.palette_offset;
+    }
+
+    if (h.compression == uint32_t(grid_compression::none)) {
+        check_range(h.cells_offset, n * elem);
+        m_view = grid_view(h.width, h.height, storage, data + h.cells_offset, palette, h.palette_size);
+        return;
+    }
+
+    // Each band is either flat, and read in place, or run-length encoded
+    // and decoded into m_decoded. The bands are checked first, so a corrupt
+    // header can't make us allocate for cells the file doesn't hold.
+    const size_t chunks = (size_t(h.height) + h.chunk_rows - 1) / h.chunk_rows;
+    check_range(h.chunks_offset, chunks * k_chunk_entry_size);
+
+    struct band {
+        const uint8_t* data;
+        uint64_t bytes;
+        bool rle;
+        size_t cells;
+    };
+    std::vector<band> bands;
+    bands.reserve(chunks);
+    size_t decoded_cells = 0;
+    byte_reader table(data + h.chunks_offset, chunks * k_chunk_entry_size);
+    for (size_t c = 0; c < chunks; ++c) {
+        const uint64_t offset = table.u64();
+        const uint64_t bytes  = table.u64();
+        const uint32_t encoding = table.u32();
+        table.u32();
+        check_range(offset, bytes);
+        const size_t begin = c * h.chunk_rows * size_t(h.width);
+        const size_t cells = std::min(n, begin + h.chunk_rows * size_t(h.width)) - begin;
+
+        if (encoding == uint32_t(grid_compression::none)) {
+            if (bytes != cells * elem)
+                throw std::runtime_error("Corrupt grid file: band has the wrong size");
+        } else if (encoding == uint32_t(grid_compression::rle)) {
+            byte_reader runs(data + offset, bytes);
+            size_t total = 0;
+            while (!runs.at_end()) {
+                const uint32_t run = runs.u32();
+                runs.bytes(elem);
+                if (run > cells - total)
+                    throw std::runtime_error("Corrupt grid file: run overflows its band");
+                total += run;
+            }
+            if (total != cells)
+                throw std::runtime_error("Corrupt grid file: band is short");
+            decoded_cells += cells;
+        } else {
+            throw std::runtime_error("Corrupt grid file: unknown band encoding");
+        }
+        bands.push_back({ data + offset, bytes, encoding != 0, cells });
+    }
+
+    m_decoded.resize(decoded_cells * elem);
+    m_bands.clear();
+    m_bands.reserve(chunks);
+    uint8_t* dst = m_decoded.data();
+    for (const auto& b : bands) {
+        if (!b.rle) {
+            m_bands.push_back(b.data);
+            continue;
+        }
+        m_bands.push_back(dst);
+        byte_reader runs(b.data, b.bytes);
+        while (!runs.at_end()) {
+            const uint32_t run = runs.u32();
+            const uint8_t* value = runs.bytes(elem);
+            for (uint32_t r = 0; r < run; ++r, dst += elem)
+                std::memcpy(dst, value, elem);
+        }
+    }
+
+    const int band_rows = int(std::min<uint32_t>(h.chunk_rows, uint32_t(INT32_MAX)));
+    m_view = grid_view(h.width, h.height, storage, m_bands.data(), band_rows, palette, h.palette_size);
+}
+
+grid_file grid_file::from_memory(const uint8_t* data, size_t size) {
+    grid_file f;
+    f.parse(data, size);
+    return f;
+}
+
+grid_file grid_file::open(const std::string& path) {
+    grid_file f;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Cannot open grid file: " + path);
+    LARGE_INTEGER file_size{};
+    GetFileSizeEx(file, &file_size);
+    HANDLE mapping = file_size.QuadPart > 0
+        ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (!mapping)
+        throw std::runtime_error("Cannot map grid file: " + path);
+    void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!base) {
+        CloseHandle(mapping);
+        throw std::runtime_error("Cannot map grid file: " + path);
+    }
+    f.m_handle = mapping;
+    f.m_mapping = base;
+    f.m_mapped_size = size_t(file_size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open grid file: " + path);
+    struct stat st{};
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        base = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        throw std::runtime_error("Cannot map grid file: " + path);
+    f.m_mapping = base;
+    f.m_mapped_size = size_t(st.st_size);
+#endif
+    // On failure the destructor of `f` releases the mapping.
+    f.parse(static_cast<const uint8_t*>(f.m_mapping), f.m_mapped_size);
+    return f;
+}
+
+grid_file::grid_file(grid_file&& other) noexcept
+    : m_mapping(std::exchange(other.m_mapping, nullptr)),
+      m_mapped_size(std::exchange(other.m_mapped_size, 0)),
+      m_handle(std::exchange(other.m_handle, nullptr)),
+      m_decoded(std::move(other.m_decoded)),
+      m_bands(std::move(other.m_bands)),
+      m_view(std::exchange(other.m_view, {})) {}
+
+grid_file& grid_file::operator=(grid_file&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        m_mapping     = std::exchange(other.m_mapping, nullptr);
+        m_mapped_size = std::exchange(other.m_mapped_size, 0);
+        m_handle      = std::exchange(other.m_handle, nullptr);
+        m_decoded     = std::move(other.m_decoded);
+        m_bands       = std::move(other.m_bands);
+        m_view        = std::exchange(other.m_view, {});
+    }
+    return *this;
+}
+
+grid_file::~grid_file() {
+    unmap();
+}
+
+void grid_file::unmap() {
+    if (!m_mapping) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(m_mapping);
+    CloseHandle(static_cast<HANDLE>(m_handle));
+#else
+    munmap(m_mapping, m_mapped_size);
+#endif
+    m_mapping = nullptr;
+    m_handle = nullptr;
+    m_mapped_size = 0;
+}
+
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "grid.hpp"
+#include "tag.hpp"
+
+namespace ls {
+
+// Binary grid files for shipping generated levels.
+//
+// Layout (little-endian, version 1):
+//   64-byte header   magic "LSGR", version, width, height, storage,
+//                    compression, chunk_rows, palette size and the offsets
+//                    of the palette, chunk table and cell data
+//   palette          u64 raw tags (palette storage only)
+//   chunk table      { u64 offset, u64 size, u32 encoding, u32 0 } per band
+//                    of chunk_rows rows (compressed files only)
+//   cells            8-byte aligned
+//
+// Uncompressed files keep the cells as a flat array, so a mapped file is
+// read in place by grid_view with no decoding. Compressed files choose per
+// band: a band that run-length encoding shrinks is stored that way and
+// decoded once when opened; any other band stays a flat (8-byte aligned)
+// array and is read in place like an uncompressed file.
+
+enum class grid_storage : uint32_t {
+    raw       = 0,   ///< one u64 tag per cell
+    palette8  = 1,   ///< u8 index into the palette per cell
+    palette16 = 2,   ///< u16 index into the palette per cell
+};
+
+enum class grid_compression : uint32_t {
+    none = 0,
+    rle  = 1,
+};
+
+struct grid_file_options {
+    /// Pick the smallest storage that fits the grid's distinct tags.
+    bool             auto_storage = true;
+    grid_storage     storage      = grid_storage::raw;   ///< used when !auto_storage
+    grid_compression compression  = grid_compression::none;   ///< allowed per band
+    int              chunk_rows   = 64;
+};
+
+/// Serialise a grid. Throws std::runtime_error if a palette storage is
+/// requested for a grid with too many distinct tags.
+std::vector<uint8_t> encode_grid(const grid& g, const grid_file_options& options = {});
+
+/// Write `encode_grid(g, options)` to a file. Throws std::runtime_error on
+/// I/O errors.
+void save_grid(const grid& g, const std::string& path, const grid_file_options& options = {});
+
+
+/// Read-only view of grid cells that live elsewhere (a mapped file, a
+/// buffer). Same accessors as grid; does not own the memory.
+class grid_view {
+public:
+    grid_view() = default;
+    /// `cells` holds width * height elements of `storage`; `palette` holds
+    /// `palette_size` little-endian u64 tags (palette storage only).
+    grid_view(int width, int height, grid_storage storage,
+              const uint8_t* cells, const uint8_t* palette, size_t palette_size)
+        : m_width(width), m_height(height), m_storage(storage),
+          m_cells(cells), m_palette(palette), m_palette_size(palette_size) {}
+
+    /// Cells split into bands of `band_rows` rows, each a flat array
+    /// wherever it lives; `bands` has one pointer per band.
+    grid_view(int width, int height, grid_storage storage, const uint8_t* const* bands, int band_rows,
+              const uint8_t* palette, size_t palette_size)
+        : m_width(width), m_height(height), m_storage(storage), m_bands(bands),
+          m_band_rows(band_rows), m_palette(palette), m_palette_size(palette_size) {}
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    grid_storage storage() const { return m_storage; }
+
+    bool in_bounds(int x, int y) const { return x >= 0 && x < m_width && y >= 0 && y < m_height; }
+
+    tag get(int x, int y) const {
+        const uint8_t* cells = m_cells;
+        if (m_bands) {
+            cells = m_bands[y / m_band_rows];
+            y %= m_band_rows;
+        }
+        const size_t i = size_t(y) * m_width + x;
+        switch (m_storage) {
+            case grid_storage::palette8:  return palette_tag(cells[i]);
+            case grid_storage::palette16: return palette_tag(load<uint16_t>(cells + 2 * i));
+            default:                      return tag(load<uint64_t>(cells + 8 * i));
+        }
+    }
+
+    tag operator()(int x, int y) const { return get(x, y); }
+
+    /// Copy into an owning grid.
+    grid to_grid() const;
+
+private:
+    template <typename T>
+    static T load(const uint8_t* p) {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        if constexpr (std::endian::native == std::endian::big) {
+            T r = 0;
+            for (size_t b = 0; b < sizeof(T); ++b) r = T(r << 8) | T((v >> (8 * b)) & 0xff);
+            v = r;
+        }
+        return v;
+    }
+
+    tag palette_tag(size_t index) const {
+        return index < m_palette_size ? tag(load<uint64_t>(m_palette + 8 * index)) : tag();
+    }
+
+    int m_width = 0;
+    int m_height = 0;
+    grid_storage m_storage = grid_storage::raw;
+    const uint8_t* m_cells = nullptr;
+    const uint8_t* const* m_bands = nullptr;    // instead of m_cells when banded
+    int m_band_rows = 0;
+    const uint8_t* m_palette = nullptr;
+    size_t m_palette_size = 0;
+};
+
+
+/// A grid file opened for reading. The file is memory-mapped and viewed in
+/// place; only run-length encoded bands of compressed files are decoded,
+/// once, into an owned buffer. The view stays valid for the lifetime of
+/// this object.
+class grid_file {
+public:
+    /// Map and validate a file, decoding its run-length encoded bands.
+    /// Throws std::runtime_error if the file can't be opened or isn't a
+    /// valid grid file.
+    static grid_file open(const std::string& path);
+
+    /// Validate a grid file already in memory. The bytes must outlive the
+    /// returned object (only run-length encoded bands are copied out).
+    static grid_file from_memory(const uint8_t* data, size_t size);
+
+    grid_file(grid_file&& other) noexcept;
+    grid_file& operator=(grid_file&& other) noexcept;
+    grid_file(const grid_file&) = delete;
+    grid_file& operator=(const grid_file&) = delete;
+    ~grid_file();
+
+    const grid_view& view() const { return m_view; }
+
+    /// Bytes of cells decoded at open; 0 if every cell is read in place.
+    size_t decoded_bytes() const { return m_decoded.size(); }
+    int width() const { return m_view.width(); }
+    int height() const { return m_view.height(); }
+
+private:
+    grid_file() = default;
+    void parse(const uint8_t* data, size_t size);
+    void unmap();
+
+    void*  m_mapping = nullptr;   // mapped base address, if any
+    size_t m_mapped_size = 0;
+    void*  m_handle = nullptr;    // platform mapping handle (Windows only)
+    std::vector<uint8_t> m_decoded;             // run-length encoded bands, decoded
+    std::vector<const uint8_t*> m_bands;        // per band, into the file or m_decoded
+    grid_view m_view;
+};
+
+}
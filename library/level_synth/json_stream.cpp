@@ -0,0 +1,244 @@
+#include "json_stream.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace ls {
+
+// ---------------------------------------------------------------------------
+// json_emitter
+// ---------------------------------------------------------------------------
+
+void json_emitter::newline(size_t depth) {
+    if (m_indent < 0) return;
+    m_out += '\n';
+    m_out.append(depth * size_t(m_indent), ' ');
+}
+
+void json_emitter::separate() {
+    if (m_after_key) {              // value of a key: stays on the key's line
+        m_after_key = false;
+        return;
+    }
+    if (m_scopes.empty()) return;
+    if (!m_scopes.back().empty) m_out += ',';
+    m_scopes.back().empty = false;
+    newline(m_scopes.size());
+}
+
+void json_emitter::open(char c, bool object) {
+    separate();
+    m_out += c;
+    m_scopes.push_back({ object, true });
+}
+
+void json_emitter::close(char c) {
+    const bool empty = m_scopes.back().empty;
+    m_scopes.pop_back();
+    if (!empty) newline(m_scopes.size());
+    m_out += c;
+}
+
+void json_emitter::key(std::string_view k) {
+    separate();
+    string(k);
+    m_out += m_indent < 0 ? ":" : ": ";
+    m_after_key = true;
+}
+
+void json_emitter::value(double v) {
+    separate();
+    if (!std::isfinite(v)) {        // JSON has no inf/nan; nlohmann writes null
+        m_out += "null";
+        return;
+    }
+    char buf[32];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+    const std::string_view s(buf, size_t(end - buf));
+    m_out += s;
+    // Keep doubles recognisable as floating point ("64.0", not "64").
+    if (s.find_first_of(".eE") == std::string_view::npos) m_out += ".0";
+}
+
+void json_emitter::value(int v) {
+    separate();
+    char buf[16];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+    m_out.append(buf, end);
+}
+
+void json_emitter::value(bool v) {
+    separate();
+    m_out += v ? "true" : "false";
+}
+
+void json_emitter::value(std::string_view v) {
+    separate();
+    string(v);
+}
+
+void json_emitter::null() {
+    separate();
+    m_out += "null";
+}
+
+void json_emitter::string(std::string_view s) {
+    static constexpr char k_hex[] = "0123456789abcdef";
+    m_out += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"':  m_out += "\\\""; break;
+            case '\\': m_out += "\\\\"; break;
+            case '\b': m_out += "\\b";  break;
+            case '\f': m_out += "\\f";  break;
+            case '\n': m_out += "\\n";  break;
+            case '\r': m_out += "\\r";  break;
+            case '\t': m_out += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    m_out += "\\u00";
+                    m_out += k_hex[(c >> 4) & 0xf];
+                    m_out += k_hex[c & 0xf];
+                } else {
+                    m_out += c;
+                }
+        }
+    }
+    m_out += '"';
+}
+
+// ---------------------------------------------------------------------------
+// json_stream_writer
+// ---------------------------------------------------------------------------
+
+void json_stream_writer::visit(std::string_view name, double& v) {
+    m_out.key(name);
+    m_out.value(v);
+}
+
+void json_stream_writer::visit(std::string_view name, int& v) {
+    m_out.key(name);
+    m_out.value(v);
+}
+
+void json_stream_writer::visit(std::string_view name, vec2& v) {
+    m_out.key(name);
+    m_out.begin_object();
+    m_out.key("x"); m_out.value(double(v.x));
+    m_out.key("y"); m_out.value(double(v.y));
+    m_out.end_object();
+}
+
+void json_stream_writer::visit(std::string_view name, std::string& v) {
+    m_out.key(name);
+    m_out.value(std::string_view(v));
+}
+
+// ---------------------------------------------------------------------------
+// read_graph_items
+// ---------------------------------------------------------------------------
+
+namespace {
+
+using json = nlohmann::json;
+
+// SAX handler that skips everything except the elements of the top-level
+// "nodes" and "wires" arrays. Each element is built into a small DOM and
+// handed off as soon as it closes.
+class graph_sax {
+public:
+    using callback = std::function<void(const json&)>;
+
+    graph_sax(const callback& on_node, const callback& on_wire)
+        : m_on_node(on_node), m_on_wire(on_wire) {}
+
+    bool null()                                  { return add(nullptr); }
+    bool boolean(bool v)                         { return add(v); }
+    bool number_integer(json::number_integer_t v)   { return add(v); }
+    bool number_unsigned(json::number_unsigned_t v) { return add(v); }
+    bool number_float(json::number_float_t v, const json::string_t&) { return add(v); }
+    bool string(json::string_t& v)               { return add(std::move(v)); }
+    bool binary(json::binary_t& v)               { return add(json::binary(std::move(v))); }
+
+    bool start_object(std::size_t) { return open(json::object()); }
+    bool start_array(std::size_t)  { return open(json::array()); }
+    bool end_object()              { return close(); }
+    bool end_array()               { return close(); }
+
+    bool key(json::string_t& k) {
+        if (m_stack.empty()) {
+            if (m_depth == 1) m_section = k;
+        } else {
+            m_key = std::move(k);
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) {
+        if (const auto* pe = dynamic_cast<const json::parse_error*>(&ex)) throw *pe;
+        throw std::runtime_error(ex.what());
+    }
+
+private:
+    // Inside the items array, directly under it (depth 2).
+    bool at_item_level() const { return m_items && m_depth == 2 && m_stack.empty(); }
+
+    bool add(json v) {
+        if (!m_stack.empty()) insert(std::move(v));
+        return true;
+    }
+
+    json* insert(json v) {
+        json& parent = *m_stack.back();
+        if (parent.is_object()) return &(parent[m_key] = std::move(v));
+        parent.push_back(std::move(v));
+        return &parent.back();
+    }
+
+    bool open(json container) {
+        if (!m_stack.empty()) {
+            m_stack.push_back(insert(std::move(container)));
+        } else if (at_item_level() && container.is_object()) {
+            m_item = std::move(container);
+            m_stack.push_back(&m_item);
+        } else if (m_depth == 1 && container.is_array()
+                   && (m_section == "nodes" || m_section == "wires")) {
+            m_items = true;
+        }
+        ++m_depth;
+        return true;
+    }
+
+    bool close() {
+        --m_depth;
+        if (!m_stack.empty()) {
+            m_stack.pop_back();
+            if (m_stack.empty())
+                (m_section == "nodes" ? m_on_node : m_on_wire)(m_item);
+        } else if (m_depth == 1) {
+            m_items = false;
+        }
+        return true;
+    }
+
+    const callback& m_on_node;
+    const callback& m_on_wire;
+    std::string m_section;          // current top-level key
+    std::string m_key;              // pending key inside the item
+    std::vector<json*> m_stack;     // open containers of the current item
+    json m_item;
+    int  m_depth = 0;
+    bool m_items = false;
+};
+
+} // anonymous namespace
+
+void read_graph_items(const std::string& text,
+                      const std::function<void(const nlohmann::json&)>& on_node,
+                      const std::function<void(const nlohmann::json&)>& on_wire) {
+    graph_sax handler(on_node, on_wire);
+    json::sax_parse(text, &handler);
+}
+
+}
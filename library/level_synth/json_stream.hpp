@@ -0,0 +1,87 @@
+#pragma once
+
+#include "node_visitor.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ls {
+
+/// Writes JSON text token by token into a string, with the same layout as
+/// `nlohmann::json::dump(indent)`. Nothing is buffered besides the output
+/// itself, so cost is proportional to the size of the text.
+///
+///     json_emitter out;
+///     out.begin_object();
+///     out.key("width"); out.value(64.0);
+///     out.end_object();
+///     std::string text = out.take();
+class json_emitter {
+public:
+    /// `indent` < 0 writes compact JSON.
+    explicit json_emitter(int indent = 2) : m_indent(indent) {}
+
+    void begin_object() { open('{', true); }
+    void end_object()   { close('}'); }
+    void begin_array()  { open('[', false); }
+    void end_array()    { close(']'); }
+
+    /// Object key; the next call writes its value.
+    void key(std::string_view k);
+
+    void value(double v);
+    void value(int v);
+    void value(bool v);
+    void value(std::string_view v);
+    void value(const char* v) { value(std::string_view(v)); }
+    void null();
+
+    std::string take() { return std::move(m_out); }
+    const std::string& str() const { return m_out; }
+
+private:
+    void open(char c, bool object);
+    void close(char c);
+    void separate();            // comma + newline before a value or key
+    void newline(size_t depth);
+    void string(std::string_view s);
+
+    struct scope { bool object; bool empty; };
+
+    std::string m_out;
+    std::vector<scope> m_scopes;
+    int  m_indent;
+    bool m_after_key = false;
+};
+
+
+/// Streaming counterpart of json_writer: writes a node's persistent state as
+/// members of the object currently open in a json_emitter.
+class json_stream_writer final : public node_visitor {
+public:
+    explicit json_stream_writer(json_emitter& out) : m_out(out) {}
+
+    void visit(std::string_view name, double& v) override;
+    void visit(std::string_view name, int& v) override;
+    void visit(std::string_view name, vec2& v) override;
+    void visit(std::string_view name, std::string& v) override;
+
+private:
+    json_emitter& m_out;
+};
+
+
+/// Reads a graph document ({ "nodes": [...], "wires": [...] }) with a SAX
+/// parser. Only the array element currently being parsed is materialised,
+/// so peak memory is one node rather than the whole document. Each element
+/// is handed to the callbacks as a small JSON object, ready for json_reader.
+/// Throws nlohmann::json::parse_error on malformed input, like json::parse.
+void read_graph_items(const std::string& text,
+                      const std::function<void(const nlohmann::json&)>& on_node,
+                      const std::function<void(const nlohmann::json&)>& on_wire);
+
+}
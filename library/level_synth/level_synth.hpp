@@ -1,16 +1,21 @@
 #pragma once
 
 #include "grid.hpp"
+#include "grid_file.hpp"
 #include "pin.hpp"
 #include "node.hpp"
 #include "eval_context.hpp"
 #include "eval_engine.hpp"
+#include "cost_model.hpp"
 #include "node_registry.hpp"
 #include "generator.hpp"
+#include "graph_optimizer.hpp"
 
+#include "nodes/node_constant_number.hpp"
 #include "nodes/node_create_grid.hpp"
 #include "nodes/node_cellular_automata.hpp"
 #include "nodes/node_input_number.hpp"
 #include "nodes/node_output_grid.hpp"
 #include "nodes/node_output_number.hpp"
+#include "nodes/node_threshold.hpp"
 #include "nodes/node_noise_grid.hpp"
@@ -0,0 +1,125 @@
+#include "lz.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ls {
+
+namespace {
+
+constexpr size_t k_min_match  = 4;
+constexpr size_t k_max_offset = 0xffff;
+constexpr int    k_hash_bits  = 14;
+
+// The last bytes are always emitted as literals, so the match finder can
+// read four bytes ahead without bounds checks.
+constexpr size_t k_tail = 8;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+uint32_t hash4(const uint8_t* p) {
+    return (read32(p) * 2654435761u) >> (32 - k_hash_bits);
+}
+
+// Lengths >= 15 spill into extra bytes of 255 each plus a remainder.
+void put_length(std::vector<uint8_t>& out, size_t n) {
+    for (; n >= 255; n -= 255) out.push_back(255);
+    out.push_back(uint8_t(n));
+}
+
+void put_sequence(std::vector<uint8_t>& out, const uint8_t* lit, size_t lit_len,
+                  size_t offset, size_t match_len) {
+    const size_t ml = match_len ? match_len - k_min_match : 0;
+    out.push_back(uint8_t((std::min<size_t>(lit_len, 15) << 4) | std::min<size_t>(ml, 15)));
+    if (lit_len >= 15) put_length(out, lit_len - 15);
+    out.insert(out.end(), lit, lit + lit_len);
+    if (match_len == 0) return;                 // final literals-only sequence
+    out.push_back(uint8_t(offset));
+    out.push_back(uint8_t(offset >> 8));
+    if (ml >= 15) put_length(out, ml - 15);
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> lz_compress(const void* data, size_t size) {
+    const auto* src = static_cast<const uint8_t*>(data);
+    std::vector<uint8_t> out;
+    out.reserve(size / 2 + 16);
+
+    std::vector<uint32_t> table(size_t(1) << k_hash_bits, UINT32_MAX);
+    size_t anchor = 0;      // start of pending literals
+    size_t i = 0;
+
+    if (size > k_tail) {
+        const size_t limit = size - k_tail;
+        while (i < limit) {
+            const uint32_t h = hash4(src + i);
+            const uint32_t cand = table[h];
+            table[h] = uint32_t(i);
+
+            if (cand == UINT32_MAX || i - cand > k_max_offset || read32(src + cand) != read32(src + i)) {
+                ++i;
+                continue;
+            }
+
+            size_t len = k_min_match;
+            while (i + len < limit && src[cand + len] == src[i + len]) ++len;
+
+            put_sequence(out, src + anchor, i - anchor, i - cand, len);
+            i += len;
+            anchor = i;
+        }
+    }
+
+    put_sequence(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+void lz_decompress(const uint8_t* data, size_t size, void* out_ptr, size_t out_size) {
+    auto* out = static_cast<uint8_t*>(out_ptr);
+    size_t ip = 0, op = 0;
+
+    auto fail = [] { throw std::runtime_error("Malformed LZ block"); };
+    auto get_length = [&](size_t n) {
+        if (n != 15) return n;
+        uint8_t b;
+        do {
+            if (ip >= size) fail();
+            b = data[ip++];
+            n += b;
+        } while (b == 255);
+        return n;
+    };
+
+    while (ip < size) {
+        const uint8_t token = data[ip++];
+
+        const size_t lit = get_length(token >> 4);
+        if (lit > size - ip || lit > out_size - op) fail();
+        std::memcpy(out + op, data + ip, lit);
+        ip += lit;
+        op += lit;
+
+        if (ip == size) break;                  // final sequence has no match
+
+        if (size - ip < 2) fail();
+        const size_t offset = size_t(data[ip]) | (size_t(data[ip + 1]) << 8);
+        ip += 2;
+        const size_t len = get_length(token & 15) + k_min_match;
+        if (offset == 0 || offset > op || len > out_size - op) fail();
+
+        // Byte by byte: matches may overlap their own output (runs).
+        const uint8_t* from = out + op - offset;
+        for (size_t k = 0; k < len; ++k) out[op + k] = from[k];
+        op += len;
+    }
+
+    if (op != out_size) fail();
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ls {
+
+// Small LZ77 codec in the style of LZ4 blocks: greedy matching through a
+// hash of the next four bytes, 64 KB window, byte-aligned sequences of
+// (token, literals, 16-bit offset, extra length). No entropy stage, so it
+// is fast in both directions. It does well on repetitive text such as graph
+// JSON, where snapshots typically shrink 5-10x.
+//
+// The compressed block does not store the original size; callers keep it
+// alongside.
+
+/// Compress `size` bytes.
+std::vector<uint8_t> lz_compress(const void* data, size_t size);
+
+inline std::vector<uint8_t> lz_compress(std::string_view s) { return lz_compress(s.data(), s.size()); }
+
+/// Decompress a block into exactly `out_size` bytes at `out`. Throws
+/// std::runtime_error if the block is malformed or doesn't decode to
+/// exactly `out_size` bytes.
+void lz_decompress(const uint8_t* data, size_t size, void* out, size_t out_size);
+
+inline std::string lz_decompress_string(const std::vector<uint8_t>& block, size_t out_size) {
+    std::string s(out_size, '\0');
+    lz_decompress(block.data(), block.size(), s.data(), out_size);
+    return s;
+}
+
+}
@@ -1,4 +1,6 @@
 #include "node.hpp"
+#include "eval_context.hpp"
+#include "grid.hpp"
 #include "node_visitor.hpp"
 
 namespace ls {
@@ -8,4 +10,17 @@ void node::accept(node_visitor& v) {
     v.visit("position", m_position);
 }
 
+bool node::evaluate_pointwise(eval_context& ctx) const {
+    const auto& pw = *descriptor().pointwise;
+    if (!ctx.has_input(pw.input)) return false;
+    auto kernel = pointwise_kernel(ctx);
+    if (!kernel) return false;
+
+    const grid& in = ctx.input_grid(pw.input);
+    auto out = std::make_shared<grid>(in.width(), in.height());
+    kernel(in.data(), out->mutable_data(), in.width() * in.height());
+    ctx.set_output_grid(pw.output, std::move(out));
+    return true;
+}
+
 }
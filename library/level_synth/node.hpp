@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "pin.hpp"
+#include "tag.hpp"
 #include "vec2.hpp"
 
 namespace ls {
@@ -12,7 +16,47 @@ class eval_context;
 class node_graph;
 class node_visitor;
 
-struct node_descriptor { std::vector<pin_descriptor> pins; };
+/// Transforms a run of cells: out[i] from in[i] for i in [0, n). The engine
+/// passes one row at a time. `in` and `out` may point to the same cells.
+using row_kernel = std::function<void(const tag* in, tag* out, int n)>;
+
+/// Marks a node as pointwise: every cell of the `output` grid depends only on
+/// the same cell of the `input` grid, plus number inputs and members. Such
+/// nodes implement node::pointwise_kernel, and the engine fuses chains of
+/// them into a single pass over the grid.
+struct pointwise_pins {
+    std::string input;
+    std::string output;
+};
+
+/// What the engine may assume about a node type. A descriptor that sets
+/// none of these (the default, e.g. for third-party nodes) gets no caching,
+/// sharing, folding or concurrency, which is always correct.
+enum node_flags : uint32_t {
+    node_flag_none        = 0,
+    /// Outputs depend only on the inputs and the accept()-visited state (and,
+    /// with node_flag_uses_rng, on the seed and node id).
+    node_flag_pure        = 1u << 0,
+    /// evaluate() draws from ctx.rng() or ctx.cell_random(), which are
+    /// seeded per node id.
+    node_flag_uses_rng    = 1u << 1,
+    /// evaluate() touches nothing but its context and its own members, so
+    /// it may run concurrently with other nodes.
+    node_flag_thread_safe = 1u << 2,
+};
+
+struct node_descriptor {
+    std::vector<pin_descriptor> pins;
+    std::optional<pointwise_pins> pointwise;
+    uint32_t flags = node_flag_none;
+
+    /// For stencil nodes: an output cell depends on input cells at most this
+    /// far away (Chebyshev distance) per application. -1 if unknown or
+    /// unbounded. Pointwise nodes are radius 0 without setting this.
+    int stencil_radius = -1;
+
+    bool has(node_flags f) const { return (flags & f) == uint32_t(f); }
+};
 
 class node {
 public:
@@ -22,6 +66,46 @@ public:
     int id() const { return m_id; }
     virtual void accept(node_visitor& v);
 
+    /// True if the node keeps persistent state that accept() does not visit.
+    /// Such nodes implement save_state() and load_state(), which undo uses
+    /// for what a structural graph_delta can't see.
+    virtual bool has_opaque_state() const { return false; }
+
+    /// The state outside accept() as an opaque blob, for has_opaque_state().
+    virtual std::string save_state() const { return {}; }
+
+    /// Restore what save_state() returned. Called after accept() state and
+    /// wires are in place.
+    virtual void load_state(const std::string& state) {}
+
+    /// True if evaluate() draws random numbers, so its outputs depend on the
+    /// seed. Such nodes are never folded into constants.
+    bool is_stochastic() const { return descriptor().has(node_flag_uses_rng); }
+
+    /// True if an identical node (same type, visited state and inputs) may
+    /// share this node's evaluation. Defaults to pure nodes that don't use
+    /// the RNG: stochastic nodes are seeded by id, so copies differ, and are
+    /// excluded unless they opt in by overriding this.
+    virtual bool is_mergeable() const {
+        return descriptor().has(node_flag_pure) && !is_stochastic();
+    }
+
+    /// How far (Chebyshev distance) an output cell's inputs reach with the
+    /// current parameters: 0 for pointwise nodes, the stencil radius for a
+    /// single-pass stencil, -1 if unknown. Iterated stencils override this.
+    /// `ctx` holds the node's number inputs where the engine knows them
+    /// ahead of evaluation.
+    virtual int stencil_reach(const eval_context& ctx) const {
+        const auto& d = descriptor();
+        return d.pointwise ? 0 : d.stencil_radius;
+    }
+
+    /// Kernel for a pointwise node (see node_descriptor::pointwise), built
+    /// from the number inputs in `ctx` and the node's members. The grid
+    /// input is not available to it. An empty kernel makes the engine fall
+    /// back to evaluate().
+    virtual row_kernel pointwise_kernel(const eval_context& ctx) const { return {}; }
+
     const std::string& name() const { return m_name; }
     void set_name(std::string name) { m_name = std::move(name); }
 
@@ -29,6 +113,10 @@ public:
     void set_position(vec2 p) { m_position = p; }
 
 protected:
+    /// evaluate() for a pointwise node: runs pointwise_kernel over the input
+    /// grid into a new output grid.
+    bool evaluate_pointwise(eval_context& ctx) const;
+
     friend class node_graph;
     int m_id = 0;
     vec2 m_position;
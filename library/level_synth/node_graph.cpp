@@ -1,6 +1,11 @@
 #include "node_graph.hpp"
+#include "binary_visitor.hpp"
+#include "json_stream.hpp"
 #include "json_visitor.hpp"
 #include "node_registry.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <unordered_set>
 
 namespace ls {
@@ -18,6 +23,12 @@ int node_graph::add_node(std::unique_ptr<node> n) {
     return id;
 }
 
+void node_graph::insert_node(int node_id, std::unique_ptr<node> n) {
+    n->m_id = node_id;
+    m_nodes[node_id] = std::move(n);
+    m_next_id = std::max(m_next_id, node_id + 1);
+}
+
 void node_graph::remove_node(int node_id) {
     m_nodes.erase(node_id);
     std::erase_if(m_wires, [node_id](const wire& w) {
@@ -29,6 +40,10 @@ void node_graph::add_wire(const wire& w) {
     m_wires.push_back(w);
 }
 
+void node_graph::insert_wire(size_t index, const wire& w) {
+    m_wires.insert(m_wires.begin() + std::min(index, m_wires.size()), w);
+}
+
 void node_graph::remove_wire(int from_node, const std::string& from_pin, int to_node, const std::string& to_pin) {
     std::erase_if(m_wires, [&](const wire& w) {
         return w.from_node == from_node && w.from_pin == from_pin && w.to_node == to_node && w.to_pin == to_pin;
@@ -57,149 +72,334 @@ const std::vector<wire>& node_graph::wires() const {
     return m_wires;
 }
 
+namespace {
+
+void write_wire(json_emitter& out, const wire& w) {
+    out.begin_object();
+    out.key("from_node"); out.value(w.from_node);
+    out.key("from_pin");  out.value(std::string_view(w.from_pin));
+    out.key("to_node");   out.value(w.to_node);
+    out.key("to_pin");    out.value(std::string_view(w.to_pin));
+    out.end_object();
+}
+
+// Writes one node object: id, type, then whatever accept() visits.
+void write_node(json_emitter& out, const node& n, const node_registration& entry) {
+    out.begin_object();
+    out.key("id");   out.value(n.id());
+    out.key("type"); out.value(std::string_view(entry.type_name));
+    json_stream_writer writer(out);
+    const_cast<node&>(n).accept(writer);
+    out.end_object();
+}
+
+wire read_wire(const nlohmann::json& jw) {
+    return {
+        jw["from_node"].get<int>(),
+        jw["from_pin"].get<std::string>(),
+        jw["to_node"].get<int>(),
+        jw["to_pin"].get<std::string>()
+    };
+}
+
+} // anonymous namespace
+
+// The JSON is streamed straight into the output string rather than built as
+// a DOM and dumped; the layout matches dump(2) apart from key order.
 std::string node_graph::save() const {
     auto& reg = ls::node_registry::instance();
 
-    nlohmann::json j;
-    j["type"] = "level_synth_graph";
-    j["version"] = 1.0;
+    json_emitter out;
+    out.begin_object();
+    out.key("type");    out.value("level_synth_graph");
+    out.key("version"); out.value(1.0);
 
-    j["nodes"] = nlohmann::json::array();
-    for (int id : node_ids()) {
-        const node* n = find_node(id);
-        if (!n) continue;
+    // Sorted by id so that saving the same graph twice gives the same text.
+    std::vector<int> ids = node_ids();
+    std::sort(ids.begin(), ids.end());
 
+    out.key("nodes");
+    out.begin_array();
+    for (int id : ids) {
+        const node* n = find_node(id);
         const auto* entry = reg.find(*n);
         assert(entry && "Node not registered");
+        write_node(out, *n, *entry);
+    }
+    out.end_array();
 
-        nlohmann::json jn;
-        jn["id"]   = n->id();
-        jn["type"] = std::string(entry->type_name);
-        json_writer writer(jn);
-        const_cast<node*>(n)->accept(writer);
+    out.key("wires");
+    out.begin_array();
+    for (const auto& w : m_wires)
+        write_wire(out, w);
+    out.end_array();
 
-        j["nodes"].push_back(std::move(jn));
-    }
+    out.end_object();
+    return out.take();
+}
 
-    j["wires"] = nlohmann::json::array();
-    for (const auto& w : m_wires) {
-        j["wires"].push_back({
-            {"from_node", w.from_node},
-            {"from_pin",  w.from_pin},
-            {"to_node",   w.to_node},
-            {"to_pin",    w.to_pin},
+void node_graph::load(const std::string& data) {
+    auto& reg = ls::node_registry::instance();
+
+    // Parse into locals first so a malformed document leaves the graph as it was.
+    std::unordered_map<int, std::unique_ptr<node>> nodes;
+    std::vector<wire> wires;
+    int next_id = 0;
+
+    read_graph_items(data,
+        [&](const nlohmann::json& jn) {
+            int saved_id     = jn["id"].get<int>();
+            std::string type = jn["type"].get<std::string>();
+
+            auto node_ptr = reg.create(type);
+            if (!node_ptr) return;
+
+            json_reader reader(jn);
+            node_ptr->accept(reader);
+
+            // Restore the original id (accept() sets name and position but not id)
+            node_ptr->m_id = saved_id;
+            nodes[saved_id] = std::move(node_ptr);
+            next_id = std::max(next_id, saved_id + 1);
+        },
+        [&](const nlohmann::json& jw) {
+            wires.push_back(read_wire(jw));
         });
-    }
 
-    return j.dump(2);
+    m_nodes   = std::move(nodes);
+    m_wires   = std::move(wires);
+    m_next_id = next_id;
 }
 
-void node_graph::load(const std::string& data) {
-    auto j = nlohmann::json::parse(data);
+// Binary layout (little-endian), version 1:
+//   "LSGB" u32 version
+//   u32 type count,  str type names     (node_registry type names)
+//   u32 field count, str field names    (names passed to visit())
+//   u32 node count,  { u32 type index, i32 id, u32 field count,
+//                      { u32 name index, u8 kind, value } }
+//   u32 wire count,  { i32 from, u16 from pin, i32 to, u16 to pin }
+//   i32 next id
+// Pins are stored as indices into the node's descriptor, types as indices
+// into the type table, so loading resolves each type name once.
+namespace {
+constexpr char     k_binary_magic[4] = { 'L', 'S', 'G', 'B' };
+constexpr uint32_t k_binary_version  = 1;
+
+// Pin names are only unique per direction (e.g. a grid filter has an input
+// and an output both called "grid").
+int pin_index(const node& n, const std::string& pin, pin_direction dir) {
+    const auto& pins = n.descriptor().pins;
+    for (size_t i = 0; i < pins.size(); ++i)
+        if (pins[i].direction == dir && pins[i].name == pin) return int(i);
+    return -1;
+}
 
-    clear();
+// Reads an element count and checks the rest of the stream could hold that
+// many elements of at least `min_bytes` each, so a corrupt count throws
+// instead of asking for gigabytes.
+uint32_t read_count(byte_reader& in, size_t min_bytes) {
+    const uint32_t n = in.u32();
+    if (n > in.remaining() / min_bytes)
+        throw std::runtime_error("Invalid element count in binary graph");
+    return n;
+}
+} // anonymous namespace
 
+std::vector<uint8_t> node_graph::save_binary() const {
     auto& reg = ls::node_registry::instance();
 
-    for (const auto& jn : j.value("nodes", nlohmann::json::array())) {
-        int saved_id     = jn["id"].get<int>();
-        std::string type = jn["type"].get<std::string>();
+    std::vector<int> ids = node_ids();
+    std::sort(ids.begin(), ids.end());
 
-        auto node_ptr = reg.create(type);
-        if (!node_ptr) continue;
+    std::vector<std::string> types;
+    std::vector<std::string> names;
+    byte_writer body;
 
-        json_reader reader(jn);
-        node_ptr->accept(reader);
+    body.u32(uint32_t(ids.size()));
+    for (int id : ids) {
+        const node* n = find_node(id);
+        const auto* entry = reg.find(*n);
+        assert(entry && "Node not registered");
+
+        auto t = std::find(types.begin(), types.end(), entry->type_name);
+        if (t == types.end()) t = types.insert(types.end(), entry->type_name);
+        body.u32(uint32_t(t - types.begin()));
+        body.i32(id);
 
-        // Restore the original id (accept() sets name and position but not id)
-        node_ptr->m_id = saved_id;
-        m_nodes[saved_id] = std::move(node_ptr);
-        m_next_id = std::max(m_next_id, saved_id + 1);
+        const size_t count_at = body.size();
+        body.u32(0);
+        binary_writer writer(body, names);
+        const_cast<node*>(n)->accept(writer);
+        body.patch_u32(count_at, writer.count());
     }
 
-    for (const auto& jw : j.value("wires", nlohmann::json::array())) {
-        m_wires.push_back({
-            jw["from_node"].get<int>(),
-            jw["from_pin"].get<std::string>(),
-            jw["to_node"].get<int>(),
-            jw["to_pin"].get<std::string>()
-        });
+    const size_t wires_at = body.size();
+    uint32_t wire_count = 0;
+    body.u32(0);
+    for (const auto& w : m_wires) {
+        const node* from = find_node(w.from_node);
+        const node* to   = find_node(w.to_node);
+        if (!from || !to) continue;                 // dangling, nothing to restore
+        const int fp = pin_index(*from, w.from_pin, pin_direction::output);
+        const int tp = pin_index(*to, w.to_pin, pin_direction::input);
+        if (fp < 0 || tp < 0) continue;
+        body.i32(w.from_node);
+        body.u16(uint16_t(fp));
+        body.i32(w.to_node);
+        body.u16(uint16_t(tp));
+        ++wire_count;
     }
+    body.patch_u32(wires_at, wire_count);
+    body.i32(m_next_id);
+
+    byte_writer out;
+    out.bytes(k_binary_magic, sizeof(k_binary_magic));
+    out.u32(k_binary_version);
+    out.u32(uint32_t(types.size()));
+    for (const auto& t : types) out.str(t);
+    out.u32(uint32_t(names.size()));
+    for (const auto& n : names) out.str(n);
+    out.bytes(body.buffer().data(), body.size());
+    return out.take();
+}
+
+void node_graph::load_binary(const uint8_t* data, size_t size) {
+    byte_reader in(data, size);
+    if (size < 4 || std::memcmp(in.bytes(4), k_binary_magic, 4) != 0)
+        throw std::runtime_error("Not a level_synth binary graph");
+    if (const uint32_t version = in.u32(); version != k_binary_version)
+        throw std::runtime_error("Unsupported binary graph version " + std::to_string(version));
+
+    auto& reg = ls::node_registry::instance();
+
+    std::vector<const node_registration*> types(read_count(in, 4));  // u32 length each
+    for (auto& t : types) {
+        const std::string type_name(in.str());
+        t = reg.find(type_name);
+        if (!t) throw std::runtime_error("Unknown node type: " + type_name);
+    }
+
+    std::vector<std::string_view> names(read_count(in, 4));
+    for (auto& n : names) n = in.str();
+
+    // Parse into locals first so malformed data leaves the graph as it was.
+    std::unordered_map<int, std::unique_ptr<node>> nodes;
+    std::vector<wire> wires;
+
+    binary_reader reader(names);
+    const uint32_t node_count = read_count(in, 12);    // type, id, field count
+    nodes.reserve(node_count);
+    int max_id = -1;
+    for (uint32_t i = 0; i < node_count; ++i) {
+        const uint32_t type = in.u32();
+        if (type >= types.size())
+            throw std::runtime_error("Invalid node type index in binary graph");
+        const int id = in.i32();
+
+        auto node_ptr = types[type]->factory();
+        reader.read(in);
+        node_ptr->accept(reader);
+        node_ptr->m_id = id;
+        if (!nodes.try_emplace(id, std::move(node_ptr)).second)
+            throw std::runtime_error("Duplicate node id in binary graph");
+        max_id = std::max(max_id, id);
+    }
+
+    const uint32_t wire_count = read_count(in, 12);
+    wires.reserve(wire_count);
+    for (uint32_t i = 0; i < wire_count; ++i) {
+        const int from = in.i32();
+        const uint16_t fp = in.u16();
+        const int to = in.i32();
+        const uint16_t tp = in.u16();
+        auto from_it = nodes.find(from);
+        auto to_it   = nodes.find(to);
+        if (from_it == nodes.end() || to_it == nodes.end()
+            || fp >= from_it->second->descriptor().pins.size()
+            || tp >= to_it->second->descriptor().pins.size())
+            throw std::runtime_error("Invalid wire in binary graph");
+        wires.push_back({ from, from_it->second->descriptor().pins[fp].name,
+                          to,   to_it->second->descriptor().pins[tp].name });
+    }
+
+    // Never hand out an id that is already taken, whatever the file says.
+    const int next_id = std::max(in.i32(), max_id + 1);
+
+    m_nodes   = std::move(nodes);
+    m_wires   = std::move(wires);
+    m_next_id = next_id;
 }
 
 std::string node_graph::save_subgraph(const std::vector<int>& ids) const {
     std::unordered_set<int> id_set(ids.begin(), ids.end());
     auto& reg = ls::node_registry::instance();
 
-    nlohmann::json j;
-    j["type"] = "level_synth_clipboard";
-    j["nodes"] = nlohmann::json::array();
-    j["wires"] = nlohmann::json::array();
+    json_emitter out;
+    out.begin_object();
+    out.key("type");
+    out.value("level_synth_clipboard");
 
+    out.key("nodes");
+    out.begin_array();
     for (int id : ids) {
         const node* n = find_node(id);
         if (!n) continue;
         const auto* entry = reg.find(*n);
         if (!entry) continue;
-
-        nlohmann::json jn;
-        jn["id"]   = n->id();
-        jn["type"] = std::string(entry->type_name);
-        json_writer writer(jn);
-        const_cast<node*>(n)->accept(writer);
-        j["nodes"].push_back(std::move(jn));
+        write_node(out, *n, *entry);
     }
+    out.end_array();
 
+    out.key("wires");
+    out.begin_array();
     for (const auto& w : m_wires) {
-        if (id_set.count(w.from_node) && id_set.count(w.to_node)) {
-            j["wires"].push_back({
-                {"from_node", w.from_node},
-                {"from_pin",  w.from_pin},
-                {"to_node",   w.to_node},
-                {"to_pin",    w.to_pin},
-            });
-        }
+        if (id_set.count(w.from_node) && id_set.count(w.to_node))
+            write_wire(out, w);
     }
+    out.end_array();
 
-    return j.dump(2);
+    out.end_object();
+    return out.take();
 }
 
 std::unordered_map<int, int> node_graph::paste_subgraph(const std::string& json_str, float offset_x, float offset_y) {
-    auto j = nlohmann::json::parse(json_str);
     auto& reg = ls::node_registry::instance();
 
-    std::unordered_map<int, int> id_map;
+    // Collect everything before touching the graph, so a malformed clipboard
+    // pastes nothing.
+    std::vector<std::pair<int, std::unique_ptr<node>>> nodes;
+    std::vector<wire> wires;
 
-    for (const auto& jn : j.value("nodes", nlohmann::json::array())) {
-        int old_id       = jn["id"].get<int>();
-        std::string type = jn["type"].get<std::string>();
+    read_graph_items(json_str,
+        [&](const nlohmann::json& jn) {
+            int old_id       = jn["id"].get<int>();
+            std::string type = jn["type"].get<std::string>();
 
-        auto node_ptr = reg.create(type);
-        if (!node_ptr) continue;
+            auto node_ptr = reg.create(type);
+            if (!node_ptr) return;
 
-        json_reader reader(jn);
-        node_ptr->accept(reader);
+            json_reader reader(jn);
+            node_ptr->accept(reader);
 
-        auto pos = node_ptr->position();
-        node_ptr->set_position({ pos.x + offset_x, pos.y + offset_y });
+            auto pos = node_ptr->position();
+            node_ptr->set_position({ pos.x + offset_x, pos.y + offset_y });
+            nodes.emplace_back(old_id, std::move(node_ptr));
+        },
+        [&](const nlohmann::json& jw) {
+            wires.push_back(read_wire(jw));
+        });
 
-        int new_id = add_node(std::move(node_ptr));
-        id_map[old_id] = new_id;
-    }
+    std::unordered_map<int, int> id_map;
+    for (auto& [old_id, node_ptr] : nodes)
+        id_map[old_id] = add_node(std::move(node_ptr));
 
-    for (const auto& jw : j.value("wires", nlohmann::json::array())) {
-        int old_from = jw["from_node"].get<int>();
-        int old_to   = jw["to_node"].get<int>();
-        auto it_from = id_map.find(old_from);
-        auto it_to   = id_map.find(old_to);
+    for (auto& w : wires) {
+        auto it_from = id_map.find(w.from_node);
+        auto it_to   = id_map.find(w.to_node);
         if (it_from == id_map.end() || it_to == id_map.end()) continue;
-
-        m_wires.push_back({
-            it_from->second,
-            jw["from_pin"].get<std::string>(),
-            it_to->second,
-            jw["to_pin"].get<std::string>()
-        });
+        w.from_node = it_from->second;
+        w.to_node   = it_to->second;
+        m_wires.push_back(std::move(w));
     }
 
     return id_map;
@@ -6,6 +6,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -18,6 +19,8 @@ struct wire {
     std::string from_pin;
     int to_node;
     std::string to_pin;
+
+    bool operator==(const wire&) const = default;
 };
 
 class node_graph {
@@ -25,6 +28,10 @@ public:
     /// Add a node to the graph. The node's ID will be set automatically. Returns the assigned ID.
     int add_node(std::unique_ptr<node> n);
 
+    /// Add a node under a given id, e.g. to restore it when undoing its
+    /// removal. Replaces any node with that id; add_node() won't reuse it.
+    void insert_node(int node_id, std::unique_ptr<node> n);
+
     /// Remove a node by id
     void remove_node(int node_id);
 
@@ -32,6 +39,10 @@ public:
     /// The destination node and all downstream nodes will be invalidated.
     void add_wire(const wire& w);
 
+    /// Add a wire at position `index` of wires() (clamped to the end), e.g.
+    /// to restore it where it was when undoing its removal.
+    void insert_wire(size_t index, const wire& w);
+
     /// Remove a wire
     void remove_wire(int from_node, const std::string& from_pin,
                      int to_node, const std::string& to_pin);
@@ -62,6 +73,15 @@ public:
     /// Load from json (existing graph will be cleared)
     void load(const std::string& data);
 
+    /// Save in the compact binary format. Meant for shipping graphs to the
+    /// runtime; JSON stays the editor interchange format.
+    std::vector<uint8_t> save_binary() const;
+
+    /// Load the binary format (existing graph will be cleared). Single pass
+    /// over the bytes, no DOM. Throws std::runtime_error on malformed data.
+    void load_binary(const uint8_t* data, size_t size);
+    void load_binary(const std::vector<uint8_t>& data) { load_binary(data.data(), data.size()); }
+
     /// Paste a clipboard JSON into the graph. Nodes get fresh IDs.
     /// Returns a map from old ID (in the JSON) to newly assigned ID.
     std::unordered_map<int, int> paste_subgraph(const std::string& json, float offset_x = 20.0f, float offset_y = 20.0f);
@@ -1,6 +1,7 @@
 #include "node_registry.hpp"
 #include "node.hpp"
 
+#include <mutex>
 #include <stdexcept>
 #include <cassert>
 
@@ -12,23 +13,38 @@ node_registry& node_registry::instance() {
 }
 
 void node_registry::register_node(node_registration&& entry) {
+    const auto idx = entry.type_idx;
+    std::unique_lock lock(m_mutex);
     auto [it, inserted] = m_entries.emplace(entry.type_name, std::move(entry));
-    assert(inserted && "Duplicate node type registration");
+    // Registering the same type under the same name again (a plugin opened
+    // by a second loader) is harmless; a different type under a taken name
+    // is not.
+    assert((inserted || it->second.type_idx == idx) && "Duplicate node type registration");
+    if (inserted) m_by_type.emplace(it->second.type_idx, &it->second);
 }
 
 std::unique_ptr<node> node_registry::create(const std::string& type_name) const {
-    auto it = m_entries.find(type_name);
-    if (it == m_entries.end())
+    const auto* entry = find(type_name);
+    if (!entry)
         throw std::runtime_error("Unknown node type: " + type_name);
-    return it->second.factory();
+    return entry->factory();
+}
+
+const node_registration* node_registry::find(const std::string& type_name) const {
+    auto lookup = [&]() -> const node_registration* {
+        std::shared_lock lock(m_mutex);
+        auto it = m_entries.find(type_name);
+        return it != m_entries.end() ? &it->second : nullptr;
+    };
+    if (const auto* entry = lookup()) return entry;
+    // Unlocked, since the resolver registers what it finds.
+    return m_resolver && m_resolver(type_name) ? lookup() : nullptr;
 }
 
 const node_registration* node_registry::find(const node& n) const {
-    const auto idx = std::type_index(typeid(n));
-    for (const auto& [_, entry] : m_entries) {
-        if (entry.type_idx == idx) return &entry;
-    }
-    return nullptr;
+    std::shared_lock lock(m_mutex);
+    auto it = m_by_type.find(std::type_index(typeid(n)));
+    return it != m_by_type.end() ? it->second : nullptr;
 }
 
 }
@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <memory>
+#include <shared_mutex>
 #include <string>
 #include <typeindex>
 #include <unordered_map>
@@ -22,6 +23,10 @@ struct node_registration {
     std::type_index type_idx;
 };
 
+/// Lookups (find, create) may run on any thread, including while another
+/// thread registers types, e.g. a plugin resolving on the UI thread while a
+/// worker evaluates. Registrations are never removed, so returned pointers
+/// stay valid.
 class node_registry {
 public:
     /// Gets the instance (Meyer's singleton)
@@ -33,16 +38,35 @@ public:
     /// Create a new node from its type name
     std::unique_ptr<node> create(const std::string& type_name) const;
 
+    /// Called with a type name that isn't registered, before create() or
+    /// find(type_name) give up. Returns true if it registered the type
+    /// (plugin_loader uses this to load plugins on first use).
+    using resolver = std::function<bool(const std::string& type_name)>;
+    void set_resolver(resolver r) { m_resolver = std::move(r); }
+
     /// Get a node registration for a given node
     const node_registration* find(const node& n) const;
 
-    /// A way to iterate over all the entries
+    /// Get a node registration by type name, consulting the resolver for
+    /// unknown names. Returns nullptr if still unknown.
+    const node_registration* find(const std::string& type_name) const;
+
+    /// A way to iterate over all the entries. Not synchronized: iterate
+    /// only on the thread that registers types.
     const std::unordered_map<std::string, node_registration>& entries() const {
         return m_entries;
     }
 
 private:
     std::unordered_map<std::string, node_registration> m_entries;
+
+    // Secondary index for find(const node&), which runs for every node on
+    // save. Points into m_entries; unordered_map nodes don't move.
+    std::unordered_map<std::type_index, const node_registration*> m_by_type;
+
+    resolver m_resolver;
+
+    mutable std::shared_mutex m_mutex;      // guards m_entries and m_by_type
 };
 
 
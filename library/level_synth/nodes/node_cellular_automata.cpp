@@ -3,6 +3,9 @@
 #include "../grid.hpp"
 #include "../node_registry.hpp"
 #include "../node_visitor.hpp"
+
+#include <algorithm>
+
 #ifdef LS_EDITOR
 #include <imgui.h>
 #include <cstring>
@@ -18,7 +21,9 @@ const node_descriptor& node_cellular_automata::descriptor() const {
             { "birth",      pin_direction::input,  pin_type::number, false },
             { "death",      pin_direction::input,  pin_type::number, false },
             { "output",     pin_direction::output, pin_type::grid,   true  },
-        }
+        },
+        .flags = node_flag_pure | node_flag_thread_safe,
+        .stencil_radius = 1,
     };
     return desc;
 }
@@ -46,18 +51,30 @@ bool node_cellular_automata::evaluate(eval_context& ctx) {
     if (ctx.has_input("birth"))      m_birth      = ctx.input_number("birth");
     if (ctx.has_input("death"))      m_death      = ctx.input_number("death");
 
-    const auto& input = ctx.input_grid("input");
-    auto output = std::make_shared<grid>(input);
+    // Progress so far, kept across suspend() when stepping.
+    struct progress {
+        std::shared_ptr<grid> output;
+        grid prev{ 0, 0 };
+        int iteration = 0;
+        int row = 0;
+    };
+    auto& p = ctx.resume_state<progress>();
+    if (!p.output) p.output = std::make_shared<grid>(ctx.input_grid("input"));
+    auto& output = p.output;
 
-    for (int i = 0; i < static_cast<int>(m_iterations); i++) {
+    const int iterations = static_cast<int>(ctx.spatial(m_iterations));
+    for (; p.iteration < iterations; p.iteration++, p.row = 0) {
+        if (ctx.cancelled()) return false;
 
         // Snapshot current state for neighbor reads
-        grid prev(*output);
+        if (p.row == 0) p.prev = *output;
+        const grid& prev = p.prev;
 
         int w = output->width();
         int h = output->height();
 
-        for (int y = 0; y < h; y++) {
+        while (p.row < h) {
+            const int y = p.row++;
             for (int x = 0; x < w; x++) {
                 int neighbors = count_neighbors(prev, x, y);
                 int alive = prev.get(x, y) != tag::numeric(0);
@@ -67,6 +84,7 @@ bool node_cellular_automata::evaluate(eval_context& ctx) {
                 else if (alive && neighbors < m_death)
                     output->set(x, y, tag::numeric(0));
             }
+            if (ctx.should_yield()) return ctx.suspend();
         }
     }
 
@@ -74,6 +92,11 @@ bool node_cellular_automata::evaluate(eval_context& ctx) {
     return true;
 }
 
+int node_cellular_automata::stencil_reach(const eval_context& ctx) const {
+    const double iterations = ctx.has_input("iterations") ? ctx.input_number("iterations") : m_iterations;
+    return std::max(0, static_cast<int>(ctx.spatial(iterations))) * descriptor().stencil_radius;
+}
+
 void node_cellular_automata::accept(node_visitor &v) {
     node::accept(v);
     v.visit("iterations", m_iterations);
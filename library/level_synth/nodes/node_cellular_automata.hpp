@@ -10,6 +10,9 @@ public:
     bool evaluate(eval_context& ctx) override;
     void accept(node_visitor &v) override;
 
+    /// Each iteration reads the 8 neighbours of the previous one.
+    int stencil_reach(const eval_context& ctx) const override;
+
 protected:
     double m_iterations = 5;
     double m_birth = 5;
@@ -0,0 +1,30 @@
+#include "node_constant_number.hpp"
+#include "../eval_context.hpp"
+#include "../node_registry.hpp"
+#include "../node_visitor.hpp"
+
+namespace ls {
+
+const node_descriptor& node_constant_number::descriptor() const {
+    static node_descriptor desc = {
+        .pins = {
+            { "value", pin_direction::output, pin_type::number, true },
+        },
+        .flags = node_flag_pure | node_flag_thread_safe,
+    };
+    return desc;
+}
+
+bool node_constant_number::evaluate(eval_context& ctx) {
+    ctx.set_output_number("value", m_value);
+    return true;
+}
+
+void node_constant_number::accept(node_visitor& v) {
+    node::accept(v);
+    v.visit("value", m_value);
+}
+
+LS_REGISTER_NODE(node_constant_number, "Constant Number", "IO");
+
+}
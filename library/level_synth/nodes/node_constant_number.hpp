@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../node.hpp"
+
+namespace ls {
+
+/// A fixed number. Unlike node_input_number it isn't a generator
+/// parameter; the graph optimizer emits these for folded subgraphs.
+class node_constant_number : public node {
+public:
+    const node_descriptor& descriptor() const override;
+    bool evaluate(eval_context& ctx) override;
+    void accept(node_visitor& v) override;
+    void set_value(double value) { m_value = value; }
+    double value() const { return m_value; }
+
+protected:
+    double m_value = 0.0;
+};
+
+}
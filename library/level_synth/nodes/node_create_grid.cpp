@@ -11,13 +11,15 @@
 namespace ls {
 
 const node_descriptor& node_create_grid::descriptor() const {
-    static node_descriptor desc{
-        {
+    static node_descriptor desc = {
+        .pins = {
             {"width",      pin_direction::input,  pin_type::number, true},
             {"height",     pin_direction::input,  pin_type::number, true},
             {"fill_value", pin_direction::input,  pin_type::number, false},
             {"grid",       pin_direction::output, pin_type::grid,   true},
-        }
+        },
+        .flags = node_flag_pure | node_flag_thread_safe,
+        .stencil_radius = 0,
     };
     return desc;
 }
@@ -27,7 +29,11 @@ bool node_create_grid::evaluate(eval_context& ctx) {
     if (ctx.has_input("height"))     m_height     = ctx.input_number("height");
     if (ctx.has_input("fill_value")) m_fill_value = tag(ctx.input_number("fill_value"));
 
-    auto gr = std::make_shared<grid>(static_cast<int>(m_width), static_cast<int>(m_height),  m_fill_value);
+    // By region, the world is unbounded and the grid covers the region.
+    const auto& region = ctx.region();
+    auto gr = region ? std::make_shared<grid>(region->width, region->height, m_fill_value)
+                     : std::make_shared<grid>(static_cast<int>(ctx.spatial(m_width)),
+                                              static_cast<int>(ctx.spatial(m_height)), m_fill_value);
     ctx.set_output_grid("grid", std::move(gr));
     return true;
 }
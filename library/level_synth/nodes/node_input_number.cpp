@@ -9,7 +9,8 @@ const node_descriptor& node_input_number::descriptor() const {
     static node_descriptor desc = {
         .pins = {
             { "value", pin_direction::output, pin_type::number, true },
-        }
+        },
+        .flags = node_flag_pure | node_flag_thread_safe,
     };
     return desc;
 }
@@ -6,19 +6,20 @@
 #include <imgui.h>
 #include <cstring>
 #endif
-#include <random>
 
 #include "level_synth/node_visitor.hpp"
 
 namespace ls {
 
 const node_descriptor& node_noise_grid::descriptor() const {
-    static node_descriptor desc{
-        {
+    static node_descriptor desc = {
+        .pins = {
             {"grid",    pin_direction::input,  pin_type::grid,   true},
             {"density", pin_direction::input,  pin_type::number, false},
             {"grid",    pin_direction::output, pin_type::grid,   true},
-        }
+        },
+        .flags = node_flag_pure | node_flag_uses_rng | node_flag_thread_safe,
+        .stencil_radius = 0,
     };
     return desc;
 }
@@ -33,12 +34,11 @@ bool node_noise_grid::evaluate(eval_context& ctx) {
     int w = gr->width();
     int h = gr->height();
 
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-    auto& rng = ctx.rng();
-
+    // Drawn per cell rather than from ctx.rng(), so a cell comes out the
+    // same in any region that contains it.
     for (int y = 0; y < h; y++) {
         for (int x = 0; x < w; x++) {
-            if (dist(rng) < m_density)
+            if (ctx.cell_random(x, y) < m_density)
                 gr->set(x, y, tag::numeric(1));
         }
     }
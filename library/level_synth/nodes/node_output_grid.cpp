@@ -8,7 +8,9 @@ const node_descriptor& node_output_grid::descriptor() const {
     static node_descriptor desc = {
         .pins = {
             { "value", pin_direction::input, pin_type::grid, true },
-        }
+        },
+        .flags = node_flag_pure | node_flag_thread_safe,
+        .stencil_radius = 0,
     };
     return desc;
 }
@@ -12,7 +12,8 @@ const node_descriptor& node_output_number::descriptor() const {
     static node_descriptor desc = {
         .pins = {
             { "value", pin_direction::input, pin_type::number, true },
-        }
+        },
+        .flags = node_flag_pure | node_flag_thread_safe,
     };
     return desc;
 }
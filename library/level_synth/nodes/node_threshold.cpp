@@ -0,0 +1,50 @@
+#include "node_threshold.hpp"
+#include "../eval_context.hpp"
+#include "../node_registry.hpp"
+#include "../node_visitor.hpp"
+
+#include <cmath>
+
+namespace ls {
+
+const node_descriptor& node_threshold::descriptor() const {
+    static node_descriptor desc = {
+        .pins = {
+            { "input",     pin_direction::input,  pin_type::grid,   true  },
+            { "threshold", pin_direction::input,  pin_type::number, false },
+            { "output",    pin_direction::output, pin_type::grid,   true  },
+        },
+        .pointwise = pointwise_pins{ "input", "output" },
+        .flags = node_flag_pure | node_flag_thread_safe,
+    };
+    return desc;
+}
+
+bool node_threshold::evaluate(eval_context& ctx) {
+    return evaluate_pointwise(ctx);
+}
+
+row_kernel node_threshold::pointwise_kernel(const eval_context& ctx) const {
+    const double threshold = ctx.has_input("threshold") ? ctx.input_number("threshold") : m_threshold;
+    const int64_t cut   = static_cast<int64_t>(std::ceil(threshold));
+    const tag     above = tag::numeric(static_cast<int64_t>(m_above));
+    const tag     below = tag::numeric(static_cast<int64_t>(m_below));
+
+    return [cut, above, below](const tag* in, tag* out, int n) {
+        for (int i = 0; i < n; ++i) {
+            const tag c = in[i];
+            out[i] = (c.type() == tag_type::numeric && c.value() >= cut) ? above : below;
+        }
+    };
+}
+
+void node_threshold::accept(node_visitor& v) {
+    node::accept(v);
+    v.visit("threshold", m_threshold);
+    v.visit("above",     m_above);
+    v.visit("below",     m_below);
+}
+
+LS_REGISTER_NODE(node_threshold, "Threshold", "Generation");
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../node.hpp"
+
+namespace ls {
+
+/// Pointwise threshold: numeric cells >= threshold become `above`, all
+/// other cells (smaller numbers and symbolic tags) become `below`.
+class node_threshold : public node {
+public:
+    const node_descriptor& descriptor() const override;
+    bool evaluate(eval_context& ctx) override;
+    void accept(node_visitor& v) override;
+    row_kernel pointwise_kernel(const eval_context& ctx) const override;
+
+protected:
+    double m_threshold = 1;
+    double m_above = 1;
+    double m_below = 0;
+};
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "node_registry.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <typeindex>
+
+/// Plugin ABI version. A plugin built against a different version is
+/// rejected before its entry point runs. Bump whenever node, node_registry
+/// or anything else a plugin node links against changes layout.
+#define LS_PLUGIN_ABI_VERSION 1
+
+#if defined(_WIN32)
+#define LS_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+#define LS_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace ls {
+
+/// Entry points a plugin library exports (unmangled, see LS_PLUGIN):
+///
+///     uint32_t ls_plugin_abi_version();
+///     void     ls_plugin_register(ls::node_registry* registry);
+using plugin_abi_version_fn = uint32_t (*)();
+using plugin_register_fn    = void (*)(node_registry*);
+
+inline constexpr const char* k_plugin_abi_version_symbol = "ls_plugin_abi_version";
+inline constexpr const char* k_plugin_register_symbol    = "ls_plugin_register";
+
+/// Register node type T from a plugin. Plugins register into the registry
+/// they are handed rather than through LS_REGISTER_NODE, whose static
+/// initializer would run at load time, before the ABI check.
+template <typename T>
+void register_plugin_node(node_registry& registry, std::string type_name,
+                          std::string display_name, std::string category) {
+    registry.register_node(node_registration{
+        std::move(type_name),
+        std::move(display_name),
+        std::move(category),
+        [] { return std::make_unique<T>(); },
+        std::type_index(typeid(T))
+    });
+}
+
+}
+
+/// Defines both plugin entry points; the body registers the plugin's nodes:
+///
+///     LS_PLUGIN(registry) {
+///         ls::register_plugin_node<node_erode>(registry, "node_erode", "Erode", "Filters");
+///     }
+#define LS_PLUGIN(registry)                                                   \
+    static void ls_plugin_register_nodes(ls::node_registry& registry);        \
+    LS_PLUGIN_EXPORT uint32_t ls_plugin_abi_version() {                       \
+        return LS_PLUGIN_ABI_VERSION;                                         \
+    }                                                                         \
+    LS_PLUGIN_EXPORT void ls_plugin_register(ls::node_registry* r) {          \
+        ls_plugin_register_nodes(*r);                                         \
+    }                                                                         \
+    static void ls_plugin_register_nodes(ls::node_registry& registry)
@@ -0,0 +1,170 @@
+#include "plugin_loader.hpp"
+#include "plugin.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace ls {
+
+namespace {
+
+constexpr const char* k_manifest_extension = ".lsplugin";
+
+#if defined(_WIN32)
+using library_handle = HMODULE;
+
+library_handle open_library(const std::filesystem::path& path) {
+    if (HMODULE h = LoadLibraryW(path.c_str())) return h;
+    throw std::runtime_error("Can't load plugin " + path.string()
+                             + " (error " + std::to_string(GetLastError()) + ")");
+}
+
+void* find_symbol(library_handle h, const char* name) {
+    return reinterpret_cast<void*>(GetProcAddress(h, name));
+}
+#else
+using library_handle = void*;
+
+library_handle open_library(const std::filesystem::path& path) {
+    if (void* h = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL)) return h;
+    const char* err = dlerror();
+    throw std::runtime_error("Can't load plugin " + path.string() + ": " + (err ? err : "unknown error"));
+}
+
+void* find_symbol(library_handle h, const char* name) {
+    return dlsym(h, name);
+}
+#endif
+
+} // anonymous namespace
+
+plugin_loader::~plugin_loader() {
+    if (m_installed) m_registry.set_resolver(nullptr);
+}
+
+void plugin_loader::add_manifest(const std::filesystem::path& manifest) {
+    std::ifstream f(manifest);
+    if (!f) throw std::runtime_error("Can't open plugin manifest " + manifest.string());
+
+    const auto fail = [&](const std::string& why) {
+        throw std::runtime_error("Plugin manifest " + manifest.string() + ": " + why);
+    };
+
+    nlohmann::json j;
+    try {
+        j = nlohmann::json::parse(f);
+    } catch (const nlohmann::json::exception& e) {
+        fail(e.what());
+    }
+    if (!j.is_object()) fail("expected an object");
+
+    const int abi = j.value("abi_version", 0);
+    if (abi != LS_PLUGIN_ABI_VERSION)
+        fail("ABI version " + std::to_string(abi) + ", expected " + std::to_string(LS_PLUGIN_ABI_VERSION));
+
+    const auto lib = j.find("library");
+    if (lib == j.end() || !lib->is_string()) fail("missing \"library\"");
+
+    plugin_info info;
+    info.library = manifest.parent_path() / lib->get<std::string>();
+    for (const auto& n : j.value("nodes", nlohmann::json::array())) {
+        if (!n.is_object() || !n.contains("type")) fail("node entry without \"type\"");
+        plugin_node_type t;
+        t.type_name    = n["type"].get<std::string>();
+        t.display_name = n.value("display_name", t.type_name);
+        t.category     = n.value("category", std::string("Plugins"));
+        info.types.push_back(std::move(t));
+    }
+    m_plugins.push_back(std::move(info));
+}
+
+size_t plugin_loader::scan(const std::filesystem::path& dir) {
+    std::error_code ec;
+    size_t count = 0;
+    for (const auto& e : std::filesystem::directory_iterator(dir, ec)) {
+        if (!e.is_regular_file() || e.path().extension() != k_manifest_extension) continue;
+        try {
+            add_manifest(e.path());
+            ++count;
+        } catch (const std::exception& ex) {
+            m_errors.emplace_back(ex.what());
+        }
+    }
+    return count;
+}
+
+void plugin_loader::load(const std::filesystem::path& library) {
+    auto it = std::find_if(m_plugins.begin(), m_plugins.end(), [&](const plugin_info& p) {
+        std::error_code ec;
+        return std::filesystem::equivalent(p.library, library, ec);
+    });
+    if (it == m_plugins.end()) {
+        m_plugins.push_back({ library, {}, false, {} });
+        it = m_plugins.end() - 1;
+    }
+    open(*it);
+}
+
+void plugin_loader::open(plugin_info& plugin) {
+    if (plugin.loaded) return;
+    const std::string name = plugin.library.string();
+
+    library_handle h = open_library(plugin.library);
+
+    auto version = reinterpret_cast<plugin_abi_version_fn>(find_symbol(h, k_plugin_abi_version_symbol));
+    auto reg     = reinterpret_cast<plugin_register_fn>(find_symbol(h, k_plugin_register_symbol));
+    if (!version || !reg)
+        throw std::runtime_error("Plugin " + name + " has no LS_PLUGIN entry points");
+    if (const uint32_t v = version(); v != LS_PLUGIN_ABI_VERSION)
+        throw std::runtime_error("Plugin " + name + " targets ABI version " + std::to_string(v)
+                                 + ", expected " + std::to_string(LS_PLUGIN_ABI_VERSION));
+
+    // The handle is deliberately never closed, see the class comment.
+    reg(&m_registry);
+    plugin.loaded = true;
+}
+
+bool plugin_loader::resolve(const std::string& type_name) {
+    for (auto& p : m_plugins) {
+        if (p.loaded || !p.error.empty()) continue;
+        const bool provides = std::any_of(p.types.begin(), p.types.end(),
+            [&](const plugin_node_type& t) { return t.type_name == type_name; });
+        if (!provides) continue;
+        try {
+            open(p);
+        } catch (const std::exception& ex) {
+            p.error = ex.what();
+            m_errors.push_back(p.error);
+            continue;
+        }
+        if (m_registry.entries().contains(type_name)) return true;
+    }
+    return m_registry.entries().contains(type_name);
+}
+
+void plugin_loader::install() {
+    m_registry.set_resolver([this](const std::string& type_name) { return resolve(type_name); });
+    m_installed = true;
+}
+
+std::vector<plugin_node_type> plugin_loader::pending_types() const {
+    std::vector<plugin_node_type> out;
+    for (const auto& p : m_plugins) {
+        if (p.loaded || !p.error.empty()) continue;
+        for (const auto& t : p.types)
+            if (!m_registry.entries().contains(t.type_name)) out.push_back(t);
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "node_registry.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace ls {
+
+/// A node type a plugin manifest says its library provides.
+struct plugin_node_type {
+    std::string type_name;
+    std::string display_name;
+    std::string category;
+};
+
+struct plugin_info {
+    std::filesystem::path library;
+    std::vector<plugin_node_type> types;
+    bool loaded = false;
+    std::string error;      // why loading failed; such plugins aren't retried
+};
+
+/// Loads node types from shared libraries.
+///
+/// A plugin is a shared library exporting the entry points defined by
+/// LS_PLUGIN (plugin.hpp), described by a manifest next to it:
+///
+///     // erosion.lsplugin
+///     {
+///         "abi_version": 1,
+///         "library": "liberosion.so",
+///         "nodes": [
+///             { "type": "node_erode", "display_name": "Erode", "category": "Filters" }
+///         ]
+///     }
+///
+/// Reading manifests is cheap and doesn't touch the libraries. A library is
+/// opened the first time one of its types is asked for, through the
+/// registry's resolver (see install()), so startup cost doesn't depend on
+/// how many plugins are installed.
+///
+/// Libraries stay loaded for the life of the process: nodes created from a
+/// plugin run its code, including their destructors.
+class plugin_loader {
+public:
+    explicit plugin_loader(node_registry& registry = node_registry::instance())
+        : m_registry(registry) {}
+
+    plugin_loader(const plugin_loader&) = delete;
+    plugin_loader& operator=(const plugin_loader&) = delete;
+
+    /// Uninstalls the resolver if installed. Loaded libraries stay loaded.
+    ~plugin_loader();
+
+    /// Reads one manifest without loading its library. The library path is
+    /// relative to the manifest. Throws std::runtime_error if the manifest
+    /// is malformed or targets another ABI version.
+    void add_manifest(const std::filesystem::path& manifest);
+
+    /// Reads every *.lsplugin manifest in `dir` (not recursive). Bad
+    /// manifests are skipped and reported through errors(). Returns the
+    /// number of manifests read.
+    size_t scan(const std::filesystem::path& dir);
+
+    /// Opens a library and registers its nodes now, whether or not a
+    /// manifest mentions it. Throws std::runtime_error if the library can't
+    /// be opened, lacks the entry points, or targets another ABI version.
+    void load(const std::filesystem::path& library);
+
+    /// Loads the plugin whose manifest lists `type_name`, if it isn't loaded
+    /// yet. Returns true if the registry knows the type afterwards. Load
+    /// failures are reported through errors().
+    bool resolve(const std::string& type_name);
+
+    /// Makes the registry call resolve() for unknown type names.
+    void install();
+
+    /// Types listed in manifests whose libraries aren't loaded yet.
+    std::vector<plugin_node_type> pending_types() const;
+
+    const std::vector<plugin_info>& plugins() const { return m_plugins; }
+    const std::vector<std::string>& errors() const { return m_errors; }
+
+private:
+    void open(plugin_info& plugin);
+
+    node_registry& m_registry;
+    std::vector<plugin_info> m_plugins;
+    std::vector<std::string> m_errors;
+    bool m_installed = false;
+};
+
+}
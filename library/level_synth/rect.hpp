@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+
+namespace ls {
+
+/// Integer cell coordinate.
+struct cell_coord {
+    int x = 0;
+    int y = 0;
+
+    bool operator==(const cell_coord&) const = default;
+};
+
+/// Axis-aligned rectangle of cells: [x, x + width) × [y, y + height).
+struct rect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+
+    /// Grow by `r` cells on every side.
+    rect expanded(int r) const { return { x - r, y - r, width + 2 * r, height + 2 * r }; }
+
+    /// Overlap of two rectangles (empty if they don't touch).
+    rect intersect(const rect& o) const {
+        const int x0 = std::max(x, o.x);
+        const int y0 = std::max(y, o.y);
+        const int x1 = std::min(x + width, o.x + o.width);
+        const int y1 = std::min(y + height, o.y + o.height);
+        return { x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0) };
+    }
+
+    /// Smallest rectangle containing both.
+    rect bounds(const rect& o) const {
+        const int x0 = std::min(x, o.x);
+        const int y0 = std::min(y, o.y);
+        return { x0, y0, std::max(x + width, o.x + o.width) - x0,
+                 std::max(y + height, o.y + o.height) - y0 };
+    }
+
+    bool operator==(const rect&) const = default;
+};
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <cassert>
 #include <cstdint>
+#include <optional>
+#include <string_view>
 
 namespace ls {
 
@@ -83,4 +85,49 @@ private:
 
 static_assert(sizeof(tag) == 8);
 
+// Segment hash used for symbolic levels: FNV-1a folded into 21 bits. 0 is
+// reserved for the wildcard, so a segment that hashes to 0 is mapped to 1.
+// constexpr so identifiers can be turned into tags at compile time; the
+// tag_registry uses the same function, so both paths agree bit for bit.
+constexpr uint32_t hash_segment(std::string_view segment) noexcept {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : segment) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ull;
+    }
+    const uint32_t r = static_cast<uint32_t>(h & tag::k_level_mask);
+    return r == 0 ? 1u : r;
+}
+
+// Hash a dotted identifier ("Wall.Damaged") into a symbolic tag. Returns
+// nullopt on structural errors: empty identifier, empty segment, or more
+// than three segments. Registration is not required (see tag_registry).
+constexpr std::optional<tag> parse_identifier(std::string_view identifier) noexcept {
+    if (identifier.empty()) return std::nullopt;
+    uint32_t ids[3] = {0, 0, 0};
+    size_t level = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= identifier.size(); ++i) {
+        if (i < identifier.size() && identifier[i] != '.') continue;
+        if (i == start || level == 3) return std::nullopt;
+        ids[level++] = hash_segment(identifier.substr(start, i - start));
+        start = i + 1;
+    }
+    return tag::symbolic(ids[0], ids[1], ids[2]);
+}
+
+namespace literals {
+
+// "Wall.Damaged"_tag builds the symbolic tag at compile time, so node code
+// can hold tag constants without parsing at run time. A malformed
+// identifier is a compile error. Literals bypass the registry; use
+// tag_registry::conflicts() in debug builds to catch segment collisions.
+consteval tag operator""_tag(const char* str, size_t len) {
+    const auto t = parse_identifier(std::string_view(str, len));
+    if (!t) throw "malformed tag identifier";
+    return *t;
+}
+
+} // namespace literals
+
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "tag_index.hpp"
+
+#include <algorithm>
+
+namespace ls {
+
+tag_index::tag_index(const tag* cells, int width, int height)
+    : m_width(width), m_height(height) {
+    // Pass 1: one mask per distinct symbolic tag. Cells are visited as runs
+    // of equal values, so the hash lookup happens once per run.
+    std::unordered_map<uint64_t, size_t> leaf_of;
+    std::vector<cell_mask> leaves;
+
+    for (int y = 0; y < height; ++y) {
+        const tag* row = cells + static_cast<size_t>(y) * width;
+        int x = 0;
+        while (x < width) {
+            const uint64_t raw = row[x].raw();
+            int end = x + 1;
+            while (end < width && row[end].raw() == raw) ++end;
+
+            if (!(raw & tag::k_mode_bit)) {
+                auto [it, inserted] = leaf_of.try_emplace(raw, leaves.size());
+                if (inserted) leaves.emplace_back(width, height);
+                leaves[it->second].set_range(y, x, end);
+            }
+            x = end;
+        }
+    }
+
+    m_tags.reserve(leaf_of.size());
+    for (const auto& [raw, _] : leaf_of)
+        m_tags.push_back(tag(raw));
+    std::sort(m_tags.begin(), m_tags.end(), [](tag a, tag b) { return a.raw() < b.raw(); });
+
+    // Pass 2: every present tag and each of its ancestors gets the union of
+    // the leaves that are-a it.
+    std::vector<tag> patterns;
+    for (tag t : m_tags) {
+        patterns.push_back(t);
+        patterns.push_back(tag::symbolic(t.l0(), 0, 0));
+        if (t.l1() != 0)
+            patterns.push_back(tag::symbolic(t.l0(), t.l1(), 0));
+    }
+
+    for (tag p : patterns) {
+        if (m_entries.contains(p.raw())) continue;
+        entry e{ cell_mask(width, height), 0 };
+        for (const auto& [raw, idx] : leaf_of)
+            if (match(tag(raw), p)) e.mask |= leaves[idx];
+        e.count = e.mask.count();
+        m_entries.emplace(p.raw(), std::move(e));
+    }
+}
+
+const cell_mask* tag_index::find(tag pattern) const {
+    auto it = m_entries.find(pattern.raw());
+    return it != m_entries.end() ? &it->second.mask : nullptr;
+}
+
+cell_mask tag_index::mask(tag pattern) const {
+    if (pattern.type() == tag_type::numeric) return cell_mask(m_width, m_height);
+    if (const auto* m = find(pattern)) return *m;
+
+    cell_mask out(m_width, m_height);
+    for (tag t : m_tags)
+        if (match(t, pattern)) out |= m_entries.at(t.raw()).mask;
+    return out;
+}
+
+size_t tag_index::count(tag pattern) const {
+    auto it = m_entries.find(pattern.raw());
+    if (it != m_entries.end()) return it->second.count;
+    return mask(pattern).count();
+}
+
+std::vector<cell_coord> tag_index::cells(tag pattern) const {
+    if (const auto* m = find(pattern)) return m->cells();
+    return mask(pattern).cells();
+}
+
+}
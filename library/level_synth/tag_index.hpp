@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "cell_mask.hpp"
+#include "rect.hpp"
+#include "tag.hpp"
+
+namespace ls {
+
+/// Bitmap index over a grid's symbolic tags.
+///
+/// Holds one cell_mask per distinct symbolic tag in the grid, and one per
+/// ancestor of those tags (Wall and Wall.Damaged for Wall.Damaged.Left),
+/// so "where is Wall" is a hash lookup instead of a scan over 64-bit
+/// cells. Ancestor masks are the union of every present tag that is-a the
+/// ancestor, i.e. they agree with `match()`.
+///
+/// Usually obtained from `grid::index()`, which builds it on first use and
+/// drops it when the grid is mutated.
+class tag_index {
+public:
+    tag_index(const tag* cells, int width, int height);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    /// Distinct symbolic tags present in the grid, sorted by raw bits.
+    const std::vector<tag>& tags() const { return m_tags; }
+
+    /// Precomputed mask for `pattern`, or nullptr if the pattern is neither
+    /// a present tag nor an ancestor of one.
+    const cell_mask* find(tag pattern) const;
+
+    /// Cells that are-a `pattern` (same rule as `match()`). Patterns not in
+    /// the index (e.g. wildcards at L0) are answered by combining the masks
+    /// of matching tags. Numeric patterns give an empty mask.
+    cell_mask mask(tag pattern) const;
+
+    /// Number of cells that are-a `pattern`.
+    size_t count(tag pattern) const;
+
+    /// Coordinates of every cell that is-a `pattern`, row-major.
+    std::vector<cell_coord> cells(tag pattern) const;
+
+private:
+    struct entry {
+        cell_mask mask;
+        size_t    count = 0;
+    };
+
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<tag> m_tags;
+    std::unordered_map<uint64_t, entry> m_entries;
+};
+
+}
@@ -0,0 +1,179 @@
+#include "tag_match.hpp"
+#include "grid.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LS_MATCH_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LS_MATCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ls {
+
+namespace {
+
+// `match(cell, pattern)` as a single masked compare:
+//   numeric pattern  -> every bit must be equal (exact match, mode bit set)
+//   symbolic pattern -> the pattern bits plus the mode bit are kept, so a
+//                       numeric cell fails on the mode bit and a symbolic
+//                       cell passes only if it contains every pattern bit.
+struct match_key {
+    uint64_t mask;
+    uint64_t value;
+};
+
+match_key make_key(tag pattern) {
+    const uint64_t p = pattern.raw();
+    return { (p & tag::k_mode_bit) ? ~uint64_t(0) : (p | tag::k_mode_bit), p };
+}
+
+// Each word kernel matches up to 64 cells and returns one bit per cell.
+using word_kernel = uint64_t (*)(const tag* cells, size_t n, match_key key);
+
+uint64_t match_word_scalar(const tag* cells, size_t n, match_key key) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < n; ++i)
+        bits |= uint64_t((cells[i].raw() & key.mask) == key.value) << i;
+    return bits;
+}
+
+#if defined(LS_MATCH_X86) && (defined(__SSE2__) || defined(_M_X64))
+// SSE2 has no 64-bit compare, so compare 32-bit halves and require both.
+uint64_t match_word_sse2(const tag* cells, size_t n, match_key key) {
+    const __m128i mask  = _mm_set1_epi64x(static_cast<long long>(key.mask));
+    const __m128i value = _mm_set1_epi64x(static_cast<long long>(key.value));
+    uint64_t bits = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128i v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i));
+        const __m128i eq32 = _mm_cmpeq_epi32(_mm_and_si128(v, mask), value);
+        const __m128i eq64 = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+        bits |= uint64_t(_mm_movemask_pd(_mm_castsi128_pd(eq64))) << i;
+    }
+    if (i < n) bits |= match_word_scalar(cells + i, n - i, key) << i;
+    return bits;
+}
+#define LS_MATCH_BASELINE match_word_sse2
+#endif
+
+// AVX2 is compiled in with a target attribute and picked at runtime on
+// GCC/Clang; MSVC only gets it when the whole build targets AVX2.
+#if defined(LS_MATCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LS_MATCH_AVX2 __attribute__((target("avx2")))
+#define LS_MATCH_AVX2_DISPATCH 1
+#elif defined(LS_MATCH_X86) && defined(__AVX2__)
+#define LS_MATCH_AVX2
+#endif
+
+#if defined(LS_MATCH_AVX2)
+LS_MATCH_AVX2
+uint64_t match_word_avx2(const tag* cells, size_t n, match_key key) {
+    const __m256i mask  = _mm256_set1_epi64x(static_cast<long long>(key.mask));
+    const __m256i value = _mm256_set1_epi64x(static_cast<long long>(key.value));
+    uint64_t bits = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + i));
+        const __m256i eq = _mm256_cmpeq_epi64(_mm256_and_si256(v, mask), value);
+        bits |= uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(eq))) << i;
+    }
+    if (i < n) bits |= match_word_scalar(cells + i, n - i, key) << i;
+    return bits;
+}
+#endif
+
+#if defined(LS_MATCH_NEON)
+uint64_t match_word_neon(const tag* cells, size_t n, match_key key) {
+    const uint64x2_t mask  = vdupq_n_u64(key.mask);
+    const uint64x2_t value = vdupq_n_u64(key.value);
+    uint64_t bits = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64x2_t v  = vld1q_u64(reinterpret_cast<const uint64_t*>(cells + i));
+        const uint64x2_t eq = vceqq_u64(vandq_u64(v, mask), value);
+        bits |= (vgetq_lane_u64(eq, 0) & 1) << i;
+        bits |= (vgetq_lane_u64(eq, 1) & 1) << (i + 1);
+    }
+    if (i < n) bits |= match_word_scalar(cells + i, n - i, key) << i;
+    return bits;
+}
+#define LS_MATCH_BASELINE match_word_neon
+#endif
+
+#ifndef LS_MATCH_BASELINE
+#define LS_MATCH_BASELINE match_word_scalar
+#endif
+
+word_kernel select_kernel() {
+#if defined(LS_MATCH_AVX2_DISPATCH)
+    if (__builtin_cpu_supports("avx2"))
+        return match_word_avx2;
+    return LS_MATCH_BASELINE;
+#elif defined(LS_MATCH_AVX2)
+    return match_word_avx2;
+#else
+    return LS_MATCH_BASELINE;
+#endif
+}
+
+word_kernel kernel() {
+    static const word_kernel k = select_kernel();
+    return k;
+}
+
+rect clip(const grid& g, rect region) {
+    return region.intersect({ 0, 0, g.width(), g.height() });
+}
+
+} // anonymous namespace
+
+void match_row(const tag* cells, size_t count, tag pattern, uint64_t* out) {
+    const auto k   = kernel();
+    const auto key = make_key(pattern);
+    for (size_t i = 0; i < count; i += 64)
+        out[i / 64] = k(cells + i, std::min<size_t>(64, count - i), key);
+}
+
+cell_mask match_mask(const grid& g, tag pattern) {
+    return match_mask(g, pattern, { 0, 0, g.width(), g.height() });
+}
+
+cell_mask match_mask(const grid& g, tag pattern, rect region) {
+    const rect r = clip(g, region);
+    cell_mask mask(r.width, r.height);
+    for (int y = 0; y < r.height; ++y)
+        match_row(g.data() + static_cast<size_t>(r.y + y) * g.width() + r.x, r.width, pattern, mask.row(y));
+    return mask;
+}
+
+size_t match_count(const grid& g, tag pattern) {
+    return match_count(g, pattern, { 0, 0, g.width(), g.height() });
+}
+
+size_t match_count(const grid& g, tag pattern, rect region) {
+    const rect r   = clip(g, region);
+    const auto k   = kernel();
+    const auto key = make_key(pattern);
+    size_t total = 0;
+    for (int y = 0; y < r.height; ++y) {
+        const tag* row = g.data() + static_cast<size_t>(r.y + y) * g.width() + r.x;
+        for (int x = 0; x < r.width; x += 64)
+            total += std::popcount(k(row + x, std::min(64, r.width - x), key));
+    }
+    return total;
+}
+
+std::vector<cell_coord> match_cells(const grid& g, tag pattern) {
+    return match_mask(g, pattern).cells();
+}
+
+std::vector<cell_coord> match_cells(const grid& g, tag pattern, rect region) {
+    const rect r = clip(g, region);
+    return match_mask(g, pattern, r).cells(r.x, r.y);
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "cell_mask.hpp"
+#include "rect.hpp"
+#include "tag.hpp"
+
+namespace ls {
+
+class grid;
+
+// Bulk versions of `match(cell, pattern)` over a whole grid or a region of
+// it. They answer "which cells are-a Wall?" without calling match() per
+// cell: the mode-bit check and the subset test collapse into one masked
+// 64-bit compare, which runs four (AVX2) or two (SSE2/NEON) cells at a time.
+//
+// Regions are clipped to the grid. A region mask covers only the clipped
+// region (bit (0, 0) is cell (region.x, region.y)); coordinate lists are
+// always in grid space.
+
+/// One bit per cell that matches `pattern`.
+cell_mask match_mask(const grid& g, tag pattern);
+cell_mask match_mask(const grid& g, tag pattern, rect region);
+
+/// Number of cells that match `pattern`.
+size_t match_count(const grid& g, tag pattern);
+size_t match_count(const grid& g, tag pattern, rect region);
+
+/// Grid coordinates of every matching cell, in row-major order.
+std::vector<cell_coord> match_cells(const grid& g, tag pattern);
+std::vector<cell_coord> match_cells(const grid& g, tag pattern, rect region);
+
+/// Low-level kernel: sets bit i of out[i / 64] for each of the `count`
+/// cells that match. `out` must hold (count + 63) / 64 words; bits past
+/// `count` in the last word are cleared.
+void match_row(const tag* cells, size_t count, tag pattern, uint64_t* out);
+
+}
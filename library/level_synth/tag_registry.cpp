@@ -22,16 +22,6 @@ std::vector<std::string> split_segments(std::string_view identifier) {
 
 } // anonymous namespace
 
-uint32_t tag_registry::hash_segment(std::string_view segment) noexcept {
-    uint64_t h = 0xcbf29ce484222325ull;
-    for (char c : segment) {
-        h ^= static_cast<uint8_t>(c);
-        h *= 0x100000001b3ull;
-    }
-    uint32_t r = static_cast<uint32_t>(h & tag::k_level_mask);
-    return r == 0 ? 1u : r;
-}
-
 bool tag_registry::add(std::string_view identifier) {
     auto segs = split_segments(identifier);
     if (segs.empty()) return false;
@@ -39,8 +29,8 @@ bool tag_registry::add(std::string_view identifier) {
     uint32_t ids[3] = {0, 0, 0};
     for (size_t i = 0; i < segs.size(); i++) {
         ids[i] = hash_segment(segs[i]);
-        auto it = m_segments.find(ids[i]);
-        if (it != m_segments.end() && it->second != segs[i])
+        const std::string* existing = m_segments.find(ids[i]);
+        if (existing && *existing != segs[i])
             return false;
         for (size_t j = 0; j < i; j++)
             if (ids[j] == ids[i] && segs[j] != segs[i])
@@ -56,10 +46,10 @@ bool tag_registry::add(std::string_view identifier) {
         uint32_t a[3] = {0, 0, 0};
         for (size_t i = 0; i < depth; ++i) a[i] = ids[i];
         const tag ancestor = tag::symbolic(a[0], a[1], a[2]);
-        if (m_tags.find(ancestor.raw()) == m_tags.end()) {
+        if (!m_tags.contains(ancestor.raw())) {
             std::string prefix = segs[0];
             for (size_t i = 1; i < depth; ++i) prefix += '.' + segs[i];
-            m_tags[ancestor.raw()] = std::move(prefix);
+            m_tags.try_emplace(ancestor.raw(), std::move(prefix));
         }
     }
     return true;
@@ -69,57 +59,56 @@ void tag_registry::remove(std::string_view identifier) {
     auto t = parse(identifier);
     if (t) {
         m_tags.erase(t->raw());
-        m_colors.erase(std::string(identifier));
+        m_colors.erase(t->raw());
     }
 }
 
 bool tag_registry::rename(std::string_view old_id, std::string_view new_id) {
-    std::string old_str(old_id);
-    std::string new_str(new_id);
-
-    if (!find(old_id))         return false;  // old not registered
+    auto old_tag = find(old_id);
+    if (!old_tag)              return false;  // old not registered
     if (find(new_id))          return false;  // new already exists
-    if (!add(new_str))         return false;  // new fails validation
+    if (!add(new_id))          return false;  // new fails validation
 
     // Migrate color before removing old entry.
-    auto it = m_colors.find(old_str);
-    if (it != m_colors.end()) {
-        m_colors[new_str] = it->second;
-        m_colors.erase(it);
+    if (const uint32_t* c = m_colors.find(old_tag->raw())) {
+        m_colors[parse(new_id)->raw()] = *c;
+        m_colors.erase(old_tag->raw());
     }
 
-    remove(old_str);
+    remove(old_id);
     return true;
 }
 
 std::optional<tag> tag_registry::parse(std::string_view identifier) const {
-    auto segs = split_segments(identifier);
-    if (segs.empty()) return std::nullopt;
-    uint32_t ids[3] = {0, 0, 0};
-    for (size_t i = 0; i < segs.size(); i++)
-        ids[i] = hash_segment(segs[i]);
-    return tag::symbolic(ids[0], ids[1], ids[2]);
+    return parse_identifier(identifier);
+}
+
+bool tag_registry::conflicts(std::string_view identifier) const {
+    for (auto seg : std::views::split(identifier, '.')) {
+        const std::string_view s(seg.begin(), seg.end());
+        const std::string* existing = m_segments.find(hash_segment(s));
+        if (existing && *existing != s) return true;
+    }
+    return false;
 }
 
 std::optional<tag> tag_registry::find(std::string_view identifier) const {
     auto t = parse(identifier);
     if (!t) return std::nullopt;
-    if (m_tags.find(t->raw()) == m_tags.end()) return std::nullopt;
+    if (!m_tags.contains(t->raw())) return std::nullopt;
     return t;
 }
 
 std::string_view tag_registry::identifier(const tag& t) const {
     if (t.type() != tag_type::symbolic) return {};
-    auto it = m_tags.find(t.raw());
-    if (it == m_tags.end()) return {};
-    return it->second;
+    const std::string* id = m_tags.find(t.raw());
+    return id ? std::string_view(*id) : std::string_view();
 }
 
 std::vector<std::string> tag_registry::all_identifiers() const {
     std::vector<std::string> result;
     result.reserve(m_tags.size());
-    for (const auto& [_, id_str] : m_tags)
-        result.push_back(id_str);
+    m_tags.for_each([&](uint64_t, const std::string& id_str) { result.push_back(id_str); });
     std::sort(result.begin(), result.end());
     return result;
 }
@@ -127,23 +116,29 @@ std::vector<std::string> tag_registry::all_identifiers() const {
 bool tag_registry::valid(const tag& t) const {
     if (t.type() == tag_type::numeric) return true;
     if (t.raw() == 0) return false;
-    return m_tags.find(t.raw()) != m_tags.end();
+    return m_tags.contains(t.raw());
 }
 
 void tag_registry::set_color(std::string_view identifier, uint32_t color) {
     // Only store colors for registered tags.
-    if (find(identifier))
-        m_colors[std::string(identifier)] = color;
+    if (auto t = find(identifier))
+        m_colors[t->raw()] = color;
 }
 
 std::optional<uint32_t> tag_registry::get_color(std::string_view identifier) const {
-    auto it = m_colors.find(std::string(identifier));
-    if (it != m_colors.end()) return it->second;
+    auto t = parse(identifier);
+    if (!t) return std::nullopt;
+    return get_color(*t);
+}
+
+std::optional<uint32_t> tag_registry::get_color(const tag& t) const {
+    if (const uint32_t* c = m_colors.find(t.raw())) return *c;
     return std::nullopt;
 }
 
 void tag_registry::clear_color(std::string_view identifier) {
-    m_colors.erase(std::string(identifier));
+    if (auto t = parse(identifier))
+        m_colors.erase(t->raw());
 }
 
 }
\ No newline at end of file
@@ -2,9 +2,9 @@
 #include <optional>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
 
+#include "flat_map.hpp"
 #include "tag.hpp"
 
 namespace ls {
@@ -36,6 +36,13 @@ public:
     // if no such symbolic tag is registered. (Does not handle numeric tags.)
     std::optional<tag> find(std::string_view identifier) const;
 
+    // True if any segment of `identifier` hashes to the same value as a
+    // different, already registered segment. Meant for debug checks on tags
+    // built without the registry (e.g. "Wall.Damaged"_tag), which would
+    // otherwise alias a registered tag silently:
+    //     assert(!registry.conflicts("Wall.Damaged"));
+    bool conflicts(std::string_view identifier) const;
+
     // Reverse lookup: get the identifier string for a registered tag.
     // Returns empty view if the tag is numeric or not registered.
     std::string_view identifier(const tag& t) const;
@@ -52,21 +59,22 @@ public:
     // Per-tag display color, stored as ImU32 (packed ABGR, same as IM_COL32).
     // Purely display metadata — does not affect tag matching.
     // Missing color = inherit from parent level (resolved by the UI layer).
+    // Colors are keyed by tag, so the tag overload is a single table probe
+    // with no allocation; use it on per-cell paths.
     void                    set_color(std::string_view identifier, uint32_t color);
     std::optional<uint32_t> get_color(std::string_view identifier) const;
+    std::optional<uint32_t> get_color(const tag& t) const;
     void                    clear_color(std::string_view identifier);
 
 private:
-    static uint32_t hash_segment(std::string_view segment) noexcept;
-
     // Registered tags: raw tag bits -> canonical identifier string.
-    std::unordered_map<uint64_t, std::string> m_tags;
+    flat_map<std::string> m_tags;
 
     // Collision detection: segment hash -> canonical segment string.
-    std::unordered_map<uint32_t, std::string> m_segments;
+    flat_map<std::string> m_segments;
 
-    // Display colors: identifier string -> packed ABGR color.
-    std::unordered_map<std::string, uint32_t> m_colors;
+    // Display colors: raw tag bits -> packed ABGR color.
+    flat_map<uint32_t> m_colors;
 };
 
 } // namespace ls
\ No newline at end of file
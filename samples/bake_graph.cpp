@@ -0,0 +1,52 @@
+// Graph bake sample
+//
+// Headless build step: loads an editor graph, optimizes it for running
+// (constant folding, dead-node removal, see graph_optimizer.hpp) and writes
+// the binary graph format the runtime loads.
+//
+// Usage: sample_bake_graph <graph.json> <graph.lsgb>
+
+#include <level_synth/level_synth.hpp>
+#include <level_synth/node_graph.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <graph.json> <graph.lsgb>\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "Can't open " << argv[1] << '\n';
+        return 1;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+
+    ls::node_graph graph;
+    try {
+        graph.load(text.str());
+    } catch (const std::exception& e) {
+        std::cerr << argv[1] << ": " << e.what() << '\n';
+        return 1;
+    }
+
+    const size_t nodes_before = graph.node_ids().size();
+    const auto report = ls::optimize_graph(graph);
+    std::cout << argv[1] << ": " << report.summary() << " ("
+              << nodes_before << " -> " << graph.node_ids().size() << " nodes)\n";
+
+    const auto bytes = graph.save_binary();
+    std::ofstream out(argv[2], std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+    if (!out) {
+        std::cerr << "Can't write " << argv[2] << '\n';
+        return 1;
+    }
+    std::cout << "Wrote " << argv[2] << " (" << bytes.size() << " bytes)\n";
+    return 0;
+}
@@ -4,6 +4,10 @@
 // with cellular automata, and prints the result as ASCII art.
 // Uses the generator API to expose named parameters and outputs.
 //
+// Usage: sample_cave_gen [level.lsgr]
+// With a path, the level is also written as a binary grid file that a game
+// can map and read in place (see grid_file.hpp).
+//
 // Graph:
 //   [InputNumber "seed_density"] --> [NoiseGrid]
 //            [CreateGrid] --------^      |
@@ -14,7 +18,7 @@
 
 #include <iostream>
 
-int main() {
+int main(int argc, char** argv) {
     ls::generator gen;
     ls::node_graph& graph = gen.graph();
 
@@ -65,9 +69,16 @@ int main() {
 
     for (int y = 0; y < grid->height(); ++y) {
         for (int x = 0; x < grid->width(); ++x)
-            std::cout << (grid->get(x, y) ? '#' : '.');
+            std::cout << (grid->get(x, y) != ls::tag::numeric(0) ? '#' : '.');
         std::cout << '\n';
     }
 
+    if (argc > 1) {
+        ls::grid_file_options options;
+        options.compression = ls::grid_compression::rle;
+        ls::save_grid(*grid, argv[1], options);
+        std::cout << "Wrote " << argv[1] << '\n';
+    }
+
     return 0;
 }
@@ -0,0 +1,40 @@
+// Plugin library used by test_plugins.cpp. Built as a module that resolves
+// the level_synth symbols it needs from the test executable.
+
+#include <level_synth/eval_context.hpp>
+#include <level_synth/node.hpp>
+#include <level_synth/node_visitor.hpp>
+#include <level_synth/plugin.hpp>
+
+namespace {
+
+class node_plugin_constant final : public ls::node {
+public:
+    const ls::node_descriptor& descriptor() const override {
+        static ls::node_descriptor desc = {
+            .pins = {
+                { "value", ls::pin_direction::output, ls::pin_type::number, false },
+            }
+        };
+        return desc;
+    }
+
+    bool evaluate(ls::eval_context& ctx) override {
+        ctx.set_output_number("value", m_value);
+        return true;
+    }
+
+    void accept(ls::node_visitor& v) override {
+        node::accept(v);
+        v.visit("value", m_value);
+    }
+
+private:
+    double m_value = 7.0;
+};
+
+} // anonymous namespace
+
+LS_PLUGIN(registry) {
+    ls::register_plugin_node<node_plugin_constant>(registry, "node_plugin_constant", "Plugin Constant", "Test");
+}
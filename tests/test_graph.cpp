@@ -0,0 +1,1129 @@
+#include <catch2/catch_test_macros.hpp>
+#include <level_synth/cost_model.hpp>
+#include <level_synth/eval_context.hpp>
+#include <level_synth/eval_engine.hpp>
+#include <level_synth/generator.hpp>
+#include <level_synth/graph_delta.hpp>
+#include <level_synth/graph_optimizer.hpp>
+#include <level_synth/grid.hpp>
+#include <level_synth/node_graph.hpp>
+#include <level_synth/node_registry.hpp>
+#include <level_synth/node_visitor.hpp>
+#include <level_synth/nodes/node_constant_number.hpp>
+#include <level_synth/nodes/node_input_number.hpp>
+#include <level_synth/nodes/node_output_number.hpp>
+
+#include <algorithm>
+#include <thread>
+
+#include <command_history.hpp>
+
+using namespace ls;
+
+namespace {
+
+node_graph make_chain() {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int noise  = g.add_node(reg.create("node_noise_grid"));
+    const int out    = g.add_node(reg.create("node_output_grid"));
+    g.add_wire({ create, "grid", noise, "grid" });
+    g.add_wire({ noise,  "grid", out,   "value" });
+    return g;
+}
+
+// a + b; a pure number node for the optimizer to fold.
+struct node_test_add final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc = { .pins = {
+            { "a",   pin_direction::input,  pin_type::number },
+            { "b",   pin_direction::input,  pin_type::number },
+            { "sum", pin_direction::output, pin_type::number },
+        }, .flags = node_flag_pure };
+        return desc;
+    }
+    bool evaluate(eval_context& ctx) override {
+        ctx.set_output_number("sum", ctx.input_number("a") + ctx.input_number("b"));
+        return true;
+    }
+};
+
+// A seed-dependent number; must survive folding.
+struct node_test_random final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc = { .pins = {
+            { "value", pin_direction::output, pin_type::number },
+        }, .flags = node_flag_pure | node_flag_uses_rng };
+        return desc;
+    }
+    bool evaluate(eval_context& ctx) override {
+        ctx.set_output_number("value", double(ctx.rng()() % 1000));
+        return true;
+    }
+};
+
+int add_constant(node_graph& g, double v) {
+    auto c = std::make_unique<node_constant_number>();
+    c->set_value(v);
+    return g.add_node(std::move(c));
+}
+
+int add_output(node_graph& g, const std::string& name) {
+    auto out = std::make_unique<node_output_number>();
+    out->set_name(name);
+    return g.add_node(std::move(out));
+}
+
+} // anonymous namespace
+
+// ---- graph_delta --------------------------------------------------------
+
+TEST_CASE("graph_delta: field edits undo and redo in place", "[graph]") {
+    node_graph g = make_chain();
+    const std::string before_json = g.save();
+    const auto before = graph_state::capture(g);
+    node* noise = g.find_node(1);
+
+    noise->set_position({ 50.0f, 60.0f });
+    noise->set_name("Sparse noise");
+    const std::string after_json = g.save();
+    const auto delta = graph_delta::diff(before, graph_state::capture(g));
+
+    REQUIRE_FALSE(delta.empty());
+    // Only the two changed fields are kept, not the graph.
+    CHECK(delta.bytes() < before_json.size());
+
+    delta.undo(g);
+    CHECK(g.find_node(1) == noise);          // same object, edited in place
+    CHECK(g.save() == before_json);
+    delta.redo(g);
+    CHECK(g.save() == after_json);
+}
+
+TEST_CASE("graph_delta: node and wire changes", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g = make_chain();
+    const std::string before_json = g.save();
+    const auto before = graph_state::capture(g);
+
+    // Remove the noise node (and its wires), add a cellular automata in
+    // its place and rewire.
+    g.remove_node(1);
+    const int ca = g.add_node(reg.create("node_cellular_automata"));
+    g.find_node(ca)->set_name("Caves");
+    g.add_wire({ 0, "grid", ca, "input" });
+    g.add_wire({ ca, "output", 2, "value" });
+    const std::string after_json = g.save();
+
+    const auto delta = graph_delta::diff(before, graph_state::capture(g));
+    delta.undo(g);
+    CHECK(g.save() == before_json);
+    CHECK(g.wires().size() == 2);
+
+    delta.redo(g);
+    CHECK(g.save() == after_json);
+
+    delta.undo(g);
+    delta.redo(g);
+    CHECK(g.save() == after_json);
+}
+
+TEST_CASE("graph_delta: wire changes in a large graph keep wire order", "[graph]") {
+    node_graph g;
+    const int one = add_constant(g, 1.0);
+    std::vector<int> adds;
+    for (int i = 0; i < 1000; ++i) {
+        adds.push_back(g.add_node(std::make_unique<node_test_add>()));
+        g.add_wire({ one, "value", adds.back(), "a" });
+        g.add_wire({ one, "value", adds.back(), "b" });
+    }
+    const std::vector<wire> before_wires = g.wires();
+    const auto before = graph_state::capture(g);
+
+    for (int i = 0; i < 1000; i += 7) g.remove_wire(one, "value", adds[i], "b");
+    for (int i = 1; i < 1000; i += 2) g.add_wire({ adds[i - 1], "sum", adds[i], "b" });
+    const std::vector<wire> after_wires = g.wires();
+
+    const auto delta = graph_delta::diff(before, graph_state::capture(g));
+    delta.undo(g);
+    CHECK(g.wires() == before_wires);
+    delta.redo(g);
+    CHECK(g.wires() == after_wires);
+}
+
+TEST_CASE("graph_delta: identical states give an empty delta", "[graph]") {
+    node_graph g = make_chain();
+    const auto a = graph_state::capture(g);
+    const auto b = graph_state::capture(g);
+    CHECK(graph_delta::diff(a, b).empty());
+    CHECK(a.opaque.empty());
+}
+
+namespace {
+
+// Keeps its strokes outside accept(), like a hand-painted mask.
+struct node_test_painted final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc = { .pins = {
+            { "value", pin_direction::output, pin_type::number },
+        } };
+        return desc;
+    }
+    bool evaluate(eval_context& ctx) override {
+        ctx.set_output_number("value", static_cast<double>(strokes.size()));
+        return true;
+    }
+    bool has_opaque_state() const override { return true; }
+    std::string save_state() const override { return strokes; }
+    void load_state(const std::string& state) override { strokes = state; }
+    std::string strokes;
+};
+
+const bool node_test_painted_registered = [] {
+    node_registry::instance().register_node({ "node_test_painted", "Painted", "Test",
+        [] { return std::make_unique<node_test_painted>(); }, typeid(node_test_painted) });
+    return true;
+}();
+
+node_test_painted* find_painted(node_graph& g, int id) {
+    return dynamic_cast<node_test_painted*>(g.find_node(id));
+}
+
+} // anonymous namespace
+
+TEST_CASE("command_history: restores state outside accept()", "[graph]") {
+    node_graph g = make_chain();
+    const int painted = g.add_node(node_registry::instance().create("node_test_painted"));
+    find_painted(g, painted)->strokes = "a";
+    const std::vector<wire> wires = g.wires();
+
+    command_history history;
+    edit_capture capture;
+
+    // An edit to opaque state alone is still a command.
+    capture.begin(g);
+    find_painted(g, painted)->strokes = "ab";
+    auto paint = capture.finish("Paint", g, history.snapshots());
+    REQUIRE(paint);
+    CHECK(paint->delta.empty());
+    history.push(std::move(*paint));
+
+    // Undoing a removal brings the strokes back along with the node.
+    capture.begin(g);
+    g.remove_node(painted);
+    auto remove = capture.finish("Delete", g, history.snapshots());
+    REQUIRE(remove);
+    history.push(std::move(*remove));
+
+    history.undo(g);
+    REQUIRE(find_painted(g, painted));
+    CHECK(find_painted(g, painted)->strokes == "ab");
+    history.undo(g);
+    CHECK(find_painted(g, painted)->strokes == "a");
+    CHECK(g.wires() == wires);
+
+    history.redo(g);
+    CHECK(find_painted(g, painted)->strokes == "ab");
+    history.redo(g);
+    CHECK_FALSE(g.find_node(painted));
+}
+
+TEST_CASE("command_history: memory limit drops the oldest entries", "[graph]") {
+    node_graph g = make_chain();
+    const int painted = g.add_node(node_registry::instance().create("node_test_painted"));
+    command_history history;
+    edit_capture capture;
+
+    // Each stroke's "after" is the next one's "before", so the store shares
+    // them and bytes() counts each once.
+    const auto stroke = [&](const std::string& strokes) {
+        capture.begin(g);
+        find_painted(g, painted)->strokes = strokes;
+        history.push(*capture.finish("Paint", g, history.snapshots()));
+    };
+    const auto recount = [&] {
+        std::unordered_map<const snapshot_store::blob*, size_t> blobs;
+        size_t n = 0;
+        for (int i = 0; i < history.size(); ++i) {
+            const auto& e = history.entry(i);
+            n += e.own_bytes();
+            e.for_each_snapshot([&](const snapshot_store::handle& h) { blobs[h.get()] = h->bytes(); });
+        }
+        for (const auto& [_, b] : blobs) n += b;
+        return n;
+    };
+
+    for (int i = 0; i < 8; ++i) stroke(std::string(size_t(1000 + i), char('a' + i)));
+    CHECK(history.bytes() == recount());
+    const size_t per_entry = history.bytes() / 8;
+
+    // Undo two and branch off; the redo entries go away.
+    history.undo(g);
+    history.undo(g);
+    stroke("branch");
+    CHECK(history.size() == 7);
+    CHECK(history.bytes() == recount());
+
+    history.set_memory_limit(3 * per_entry);
+    CHECK(history.size() < 7);
+    CHECK(history.size() >= 1);
+    CHECK(history.bytes() <= 3 * per_entry);
+    CHECK(history.bytes() == recount());
+
+    history.undo(g);
+    CHECK(find_painted(g, painted)->strokes == std::string(1005, 'f'));
+
+    history.clear();
+    CHECK(history.bytes() == 0);
+}
+
+// ---- graph optimizer ----------------------------------------------------
+
+TEST_CASE("optimizer: folds constant number chains", "[graph]") {
+    generator gen;
+    node_graph& g = gen.graph();
+    const int two   = add_constant(g, 2.0);
+    const int three = add_constant(g, 3.0);
+    const int add1  = g.add_node(std::make_unique<node_test_add>());
+    const int add2  = g.add_node(std::make_unique<node_test_add>());
+    const int out   = add_output(g, "total");
+    g.add_wire({ two,   "value", add1, "a" });
+    g.add_wire({ three, "value", add1, "b" });
+    g.add_wire({ add1,  "sum",   add2, "a" });
+    g.add_wire({ add1,  "sum",   add2, "b" });
+    g.add_wire({ add2,  "sum",   out,  "value" });
+
+    const auto report = gen.optimize();
+    CHECK(report.folded == std::vector<int>{ add1, add2 });
+    REQUIRE(report.constants.size() == 1);
+    // The input constants only fed folded nodes.
+    CHECK(report.removed == std::vector<int>{ two, three });
+    CHECK(report.summary() == "folded 2 nodes into 1 constant, removed 2 unreachable nodes");
+
+    const auto* c = dynamic_cast<const node_constant_number*>(g.find_node(report.constants[0]));
+    REQUIRE(c);
+    CHECK(c->value() == 10.0);
+    CHECK(g.node_ids().size() == 2);
+
+    gen.evaluate();
+    CHECK(gen.get_number_output("total") == 10.0);
+}
+
+TEST_CASE("optimizer: parameters and stochastic nodes are not folded", "[graph]") {
+    generator gen;
+    node_graph& g = gen.graph();
+    auto param = std::make_unique<node_input_number>();
+    param->set_name("bias");
+    param->set_value(1.0);
+    const int bias   = g.add_node(std::move(param));
+    const int random = g.add_node(std::make_unique<node_test_random>());
+    const int add    = g.add_node(std::make_unique<node_test_add>());
+    const int out    = add_output(g, "total");
+    g.add_wire({ bias,   "value", add, "a" });
+    g.add_wire({ random, "value", add, "b" });
+    g.add_wire({ add,    "sum",   out, "value" });
+
+    const std::vector<wire> wires = g.wires();
+    const auto report = gen.optimize();
+    CHECK_FALSE(report.changed());
+    CHECK(report.summary() == "nothing to optimize");
+    CHECK(g.node_ids().size() == 4);
+    CHECK(g.wires() == wires);
+
+    gen.set_parameter("bias", 5.0);
+    CHECK_NOTHROW(gen.evaluate());
+}
+
+TEST_CASE("optimizer: removes nodes no output depends on", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g = make_chain();
+    const int stray_noise  = g.add_node(reg.create("node_noise_grid"));
+    const int stray_create = g.add_node(reg.create("node_create_grid"));
+    const int unused_param = g.add_node(reg.create("node_input_number"));
+    g.add_wire({ stray_create, "grid", stray_noise, "grid" });
+
+    const auto report = optimize_graph(g);
+    CHECK(report.folded.empty());
+    CHECK(report.removed == std::vector<int>{ stray_noise, stray_create });
+    CHECK(g.find_node(unused_param));       // parameters are interface
+    CHECK(g.node_ids().size() == 4);
+    CHECK(g.wires().size() == 2);
+
+    // No outputs at all: nothing is considered dead.
+    node_graph empty_out;
+    empty_out.add_node(reg.create("node_noise_grid"));
+    CHECK_FALSE(optimize_graph(empty_out).changed());
+}
+
+// ---- common subexpression elimination ---------------------------------
+
+namespace {
+
+struct width_setter final : node_visitor {
+    double width;
+    explicit width_setter(double w) : width(w) {}
+    void visit(std::string_view name, double& v) override { if (name == "width") v = width; }
+};
+
+} // anonymous namespace
+
+TEST_CASE("eval_engine: identical nodes are evaluated once", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create_a = g.add_node(reg.create("node_create_grid"));
+    const int create_b = g.add_node(reg.create("node_create_grid"));
+    const int ca_a     = g.add_node(reg.create("node_cellular_automata"));
+    const int ca_b     = g.add_node(reg.create("node_cellular_automata"));
+    g.find_node(create_b)->set_name("Copy");                // metadata doesn't count
+    g.find_node(create_b)->set_position({ 300.0f, 0.0f });
+    g.add_wire({ create_a, "grid", ca_a, "input" });
+    g.add_wire({ create_b, "grid", ca_b, "input" });
+
+    eval_engine engine;
+    engine.evaluate(g);
+    CHECK(engine.merged_count() == 2);
+    const auto* a = engine.get_output(ca_a, "output");
+    const auto* b = engine.get_output(ca_b, "output");
+    REQUIRE(a);
+    REQUIRE(b);
+    CHECK(std::get<std::shared_ptr<grid>>(*a) == std::get<std::shared_ptr<grid>>(*b));
+
+    // A differing parameter splits the class, and so does everything
+    // downstream of it.
+    width_setter wider(128.0);
+    g.find_node(create_b)->accept(wider);
+    engine.evaluate(g);
+    CHECK(engine.merged_count() == 0);
+
+    width_setter same(64.0);
+    g.find_node(create_b)->accept(same);
+    engine.evaluate(g);
+    CHECK(engine.merged_count() == 2);
+
+    engine.set_merge_identical(false);
+    engine.evaluate(g);
+    CHECK(engine.merged_count() == 0);
+}
+
+TEST_CASE("eval_engine: colliding key hashes are told apart", "[graph]") {
+    node_graph g;
+    const int two   = add_constant(g, 2.0);
+    const int three = add_constant(g, 3.0);
+    const int copy  = add_constant(g, 2.0);
+    const int sum   = g.add_node(std::make_unique<node_test_add>());
+    g.add_wire({ two,   "value", sum, "a" });
+    g.add_wire({ three, "value", sum, "b" });
+
+    // Every key lands in one bucket; only full comparison separates them.
+    eval_engine engine;
+    engine.set_key_hash([](std::string_view) { return uint64_t(42); });
+    engine.evaluate(g);
+    CHECK(engine.merged_count() == 1);                  // copy shares two
+    const auto number = [&](int id, const char* pin) { return std::get<double>(*engine.get_output(id, pin)); };
+    CHECK(number(three, "value") == 3.0);
+    CHECK(number(copy, "value") == 2.0);
+    CHECK(number(sum, "sum") == 5.0);
+
+    // Reuse is confirmed the same way.
+    static_cast<node_constant_number*>(g.find_node(three))->set_value(4.0);
+    engine.evaluate(g);
+    CHECK(engine.reused_count() == 2);                  // two and copy
+    CHECK(number(three, "value") == 4.0);
+    CHECK(number(sum, "sum") == 6.0);
+
+    // Swapping the hash keeps the cache.
+    engine.set_key_hash([](std::string_view s) { return uint64_t(s.size()); });
+    engine.evaluate(g);
+    CHECK(engine.reused_count() == 4);
+}
+
+TEST_CASE("eval_engine: stochastic nodes are not merged", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create  = g.add_node(reg.create("node_create_grid"));
+    const int noise_a = g.add_node(reg.create("node_noise_grid"));
+    const int noise_b = g.add_node(reg.create("node_noise_grid"));
+    g.add_wire({ create, "grid", noise_a, "grid" });
+    g.add_wire({ create, "grid", noise_b, "grid" });
+
+    eval_engine engine;
+    engine.evaluate(g, 7);
+    CHECK(engine.merged_count() == 0);
+    const auto& a = *std::get<std::shared_ptr<grid>>(*engine.get_output(noise_a, "grid"));
+    const auto& b = *std::get<std::shared_ptr<grid>>(*engine.get_output(noise_b, "grid"));
+    bool differ = false;
+    for (int y = 0; y < a.height() && !differ; ++y)
+        for (int x = 0; x < a.width() && !differ; ++x)
+            differ = a.get(x, y) != b.get(x, y);
+    CHECK(differ);
+}
+
+// ---- pointwise fusion ---------------------------------------------------
+
+namespace {
+
+struct number_setter final : node_visitor {
+    std::string_view field;
+    double value;
+    number_setter(std::string_view f, double v) : field(f), value(v) {}
+    void visit(std::string_view name, double& v) override { if (name == field) v = value; }
+};
+
+int add_threshold(node_graph& g, double threshold, double above, double below) {
+    const int id = g.add_node(node_registry::instance().create("node_threshold"));
+    for (auto [field, v] : { std::pair{ "threshold", threshold }, { "above", above }, { "below", below } }) {
+        number_setter s(field, v);
+        g.find_node(id)->accept(s);
+    }
+    return id;
+}
+
+std::shared_ptr<grid> grid_output(const eval_engine& e, int id, const std::string& pin) {
+    const pin_value* v = e.get_output(id, pin);
+    return v ? std::get<std::shared_ptr<grid>>(*v) : nullptr;
+}
+
+} // anonymous namespace
+
+TEST_CASE("eval_engine: pointwise chains run as one pass", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int noise  = g.add_node(reg.create("node_noise_grid"));
+    const int th1    = add_threshold(g, 1, 10, 20);     // 1 -> 10, 0 -> 20
+    const int th2    = add_threshold(g, 15, 7, 8);      // 10 -> 8, 20 -> 7
+    const int th3    = add_threshold(g, 8, 1, 0);       // 8 -> 1, 7 -> 0
+    const int out    = g.add_node(reg.create("node_output_grid"));
+    g.add_wire({ create, "grid",   noise, "grid" });
+    g.add_wire({ noise,  "grid",   th1,   "input" });
+    g.add_wire({ th1,    "output", th2,   "input" });
+    g.add_wire({ th2,    "output", th3,   "input" });
+    g.add_wire({ th3,    "output", out,   "value" });
+
+    eval_engine fused;
+    fused.evaluate(g, 3);
+    CHECK(fused.fused_count() == 2);
+    CHECK_FALSE(fused.get_output(th1, "output"));     // never written
+    CHECK_FALSE(fused.get_output(th2, "output"));
+    // The pass still counts toward the fused types' cost estimates.
+    const size_t cells = size_t(grid_output(fused, th3, "output")->width())
+                       * size_t(grid_output(fused, th3, "output")->height());
+    const auto& costs = fused.costs().entries();
+    auto it = costs.find({ "node_threshold", cost_model::size_class(cells) });
+    REQUIRE(it != costs.end());
+    CHECK(it->second.samples == 3);
+
+    eval_engine plain;
+    plain.set_fuse_pointwise(false);
+    plain.evaluate(g, 3);
+    CHECK(plain.fused_count() == 0);
+    REQUIRE(grid_output(plain, th1, "output"));
+
+    // Same result as node by node: noise cells back as 1, empty cells as 0.
+    const auto noise_grid = grid_output(fused, noise, "grid");
+    const auto result     = grid_output(fused, th3, "output");
+    const auto expected   = grid_output(plain, th3, "output");
+    REQUIRE(noise_grid);
+    REQUIRE(result);
+    REQUIRE(expected);
+    CHECK(result->width() == noise_grid->width());
+    bool same = true;
+    for (int y = 0; y < result->height(); ++y)
+        for (int x = 0; x < result->width(); ++x) {
+            const bool set = noise_grid->get(x, y) == tag::numeric(1);
+            same &= result->get(x, y) == tag::numeric(set ? 1 : 0)
+                 && result->get(x, y) == expected->get(x, y);
+        }
+    CHECK(same);
+}
+
+TEST_CASE("eval_engine: pointwise outputs with several consumers are written", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int th1    = add_threshold(g, 1, 5, 6);
+    const int th2    = add_threshold(g, 5, 1, 0);
+    const int th3    = add_threshold(g, 6, 1, 0);
+    g.add_wire({ create, "grid",   th1, "input" });
+    g.add_wire({ th1,    "output", th2, "input" });
+    g.add_wire({ th1,    "output", th3, "input" });
+
+    eval_engine e;
+    e.set_merge_identical(false);
+    e.evaluate(g);
+    CHECK(e.fused_count() == 0);
+    REQUIRE(grid_output(e, th1, "output"));
+    CHECK(grid_output(e, th1, "output")->get(0, 0) == tag::numeric(6));   // empty grid: below
+    CHECK(grid_output(e, th2, "output")->get(0, 0) == tag::numeric(1));
+    CHECK(grid_output(e, th3, "output")->get(0, 0) == tag::numeric(1));
+}
+
+// ---- node flags and incremental evaluation ------------------------------
+
+namespace {
+
+// Counts its evaluations; declares no flags, like a third-party node.
+struct node_test_counter final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc = { .pins = {
+            { "value", pin_direction::output, pin_type::number },
+        } };
+        return desc;
+    }
+    bool evaluate(eval_context& ctx) override {
+        ctx.set_output_number("value", ++runs);
+        return true;
+    }
+    int runs = 0;
+};
+
+} // anonymous namespace
+
+TEST_CASE("node flags: built-in descriptors", "[graph]") {
+    auto& reg = node_registry::instance();
+    const auto noise = reg.create("node_noise_grid");
+    const auto ca    = reg.create("node_cellular_automata");
+    const auto th    = reg.create("node_threshold");
+    const auto input = reg.create("node_input_number");
+
+    CHECK(noise->is_stochastic());
+    CHECK_FALSE(noise->is_mergeable());
+    CHECK(noise->descriptor().has(node_flag_thread_safe));
+    CHECK_FALSE(input->is_stochastic());
+    CHECK(input->is_mergeable());
+    for (const auto* n : { noise.get(), ca.get(), th.get(), input.get() })
+        CHECK(n->descriptor().has(node_flag_pure));
+
+    CHECK(ca->descriptor().stencil_radius == 1);
+    CHECK(ca->stencil_reach(eval_context{}) == 5);                    // 5 iterations by default
+    number_setter once("iterations", 1);
+    ca->accept(once);
+    CHECK(ca->stencil_reach(eval_context{}) == 1);
+    CHECK(th->stencil_reach(eval_context{}) == 0);
+
+    node_test_counter unknown;
+    CHECK_FALSE(unknown.descriptor().has(node_flag_pure));
+    CHECK_FALSE(unknown.is_mergeable());
+    CHECK(unknown.stencil_reach(eval_context{}) == -1);
+}
+
+TEST_CASE("eval_engine: unchanged nodes keep their outputs", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int ca     = g.add_node(reg.create("node_cellular_automata"));
+    const int out    = g.add_node(reg.create("node_output_grid"));
+    g.add_wire({ create, "grid",   ca,  "input" });
+    g.add_wire({ ca,     "output", out, "value" });
+
+    eval_engine engine;
+    engine.evaluate(g);
+    CHECK(engine.reused_count() == 0);
+    const auto first = grid_output(engine, out, "value");
+    REQUIRE(first);
+
+    engine.evaluate(g);
+    CHECK(engine.reused_count() == 3);
+    CHECK(grid_output(engine, out, "value") == first);
+
+    // A parameter change re-runs the node and everything downstream.
+    number_setter birth("birth", 4);
+    g.find_node(ca)->accept(birth);
+    engine.evaluate(g);
+    CHECK(engine.reused_count() == 1);
+    CHECK(grid_output(engine, out, "value") != first);
+
+    // Nothing here uses the RNG, so a new seed changes nothing.
+    engine.evaluate(g, 42);
+    CHECK(engine.reused_count() == 3);
+
+    engine.invalidate_all();
+    engine.evaluate(g, 42);
+    CHECK(engine.reused_count() == 0);
+}
+
+TEST_CASE("eval_engine: per-node stats of the last evaluation", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int th1    = add_threshold(g, 1, 1, 0);
+    const int th2    = add_threshold(g, 1, 1, 0);
+    const int out    = g.add_node(reg.create("node_output_grid"));
+    g.add_wire({ create, "grid",   th1, "input" });
+    g.add_wire({ th1,    "output", th2, "input" });
+    g.add_wire({ th2,    "output", out, "value" });
+
+    using outcome = eval_engine::node_stats::outcome;
+    eval_engine engine;
+    engine.evaluate(g);
+    const auto& stats = engine.last_node_stats();
+    REQUIRE(stats.size() == 4);
+    const auto grid = grid_output(engine, create, "grid");
+    REQUIRE(grid);
+    const size_t bytes = size_t(grid->width()) * size_t(grid->height()) * sizeof(tag);
+    CHECK(stats.at(create).result == outcome::evaluated);
+    CHECK(stats.at(create).output_bytes == bytes);
+    CHECK(stats.at(th1).result == outcome::fused);
+    CHECK(stats.at(th1).output_bytes == 0);
+    CHECK(stats.at(th2).result == outcome::evaluated);
+    CHECK(stats.at(th2).output_bytes == bytes);
+    CHECK(stats.at(out).output_bytes == bytes);
+
+    // Nothing changed: every node keeps its outputs and takes no time.
+    engine.evaluate(g);
+    for (int id : { create, th2, out }) {
+        CHECK(stats.at(id).result == outcome::reused);
+        CHECK(stats.at(id).us == 0);
+    }
+    CHECK(stats.at(create).output_bytes == bytes);
+}
+
+TEST_CASE("eval_engine: a new seed re-runs stochastic nodes only", "[graph]") {
+    node_graph g = make_chain();        // create -> noise -> output
+    eval_engine engine;
+    engine.evaluate(g, 1);
+    engine.evaluate(g, 2);
+    CHECK(engine.reused_count() == 1);
+    engine.evaluate(g, 2);
+    CHECK(engine.reused_count() == 3);
+}
+
+TEST_CASE("eval_engine: nodes without flags are always evaluated", "[graph]") {
+    node_graph g;
+    const int a = g.add_node(std::make_unique<node_test_counter>());
+    const int b = g.add_node(std::make_unique<node_test_counter>());
+    const int out = add_output(g, "n");
+    g.add_wire({ a, "value", out, "value" });
+
+    eval_engine engine;
+    engine.evaluate(g);
+    engine.evaluate(g);
+    CHECK(engine.merged_count() == 0);
+    CHECK(engine.reused_count() == 0);      // nor is anything downstream
+    CHECK(static_cast<node_test_counter*>(g.find_node(a))->runs == 2);
+    CHECK(static_cast<node_test_counter*>(g.find_node(b))->runs == 2);
+    CHECK(std::get<double>(*engine.get_output(out, "value")) == 2);
+}
+
+// ---- cost model and parallel evaluation ---------------------------------
+
+TEST_CASE("cost_model: running estimates by type and grid size", "[graph]") {
+    cost_model costs;
+    CHECK_FALSE(costs.predict("node_threshold", 4096));
+
+    costs.record("node_threshold", 4096, 100);
+    costs.record("node_threshold", 4096, 300);
+    REQUIRE(costs.predict("node_threshold", 4096));
+    CHECK(*costs.predict("node_threshold", 4096) == 200);
+    CHECK(costs.entries().at({ "node_threshold", cost_model::size_class(4096) }).samples == 2);
+
+    // Unmeasured sizes scale from the nearest measured one.
+    CHECK(*costs.predict("node_threshold", 4 * 4096) == 800);
+    CHECK(*costs.predict("node_threshold", 4096 / 2) == 100);
+
+    // Old samples fade out.
+    for (int i = 0; i < 50; ++i) costs.record("node_threshold", 4096, 1000);
+    CHECK(*costs.predict("node_threshold", 4096) > 990);
+
+    costs.clear();
+    CHECK(costs.entries().empty());
+}
+
+namespace {
+
+std::vector<int> g_started;     // ids in the order node_test_step ran
+
+// Passes a number through; no flags, so never cached and never concurrent
+// with another node_test_step.
+template <int Kind>
+struct node_test_step final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc = { .pins = {
+            { "in",  pin_direction::input,  pin_type::number, false },
+            { "out", pin_direction::output, pin_type::number },
+        } };
+        return desc;
+    }
+    bool evaluate(eval_context& ctx) override {
+        g_started.push_back(id());
+        ctx.set_output_number("out", ctx.has_input("in") ? ctx.input_number("in") + 1 : 0);
+        return true;
+    }
+};
+
+using node_test_slow  = node_test_step<0>;
+using node_test_cheap = node_test_step<1>;
+
+} // anonymous namespace
+
+TEST_CASE("eval_engine: parallel evaluation matches serial", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    std::vector<int> outs;
+    for (int i = 0; i < 6; ++i) {
+        const int create = g.add_node(reg.create("node_create_grid"));
+        const int noise  = g.add_node(reg.create("node_noise_grid"));
+        const int ca     = g.add_node(reg.create("node_cellular_automata"));
+        const int th1    = add_threshold(g, 1, 10, 20);
+        const int th2    = add_threshold(g, 15, 1, 0);
+        const int out    = g.add_node(reg.create("node_output_grid"));
+        g.add_wire({ create, "grid",   noise, "grid" });
+        g.add_wire({ noise,  "grid",   ca,    "input" });
+        g.add_wire({ ca,     "output", th1,   "input" });
+        g.add_wire({ th1,    "output", th2,   "input" });
+        g.add_wire({ th2,    "output", out,   "value" });
+        outs.push_back(out);
+    }
+
+    eval_engine serial;
+    serial.evaluate(g, 5);
+    eval_engine parallel;
+    parallel.set_threads(4);
+    parallel.evaluate(g, 5);
+
+    CHECK(parallel.merged_count() == serial.merged_count());
+    CHECK(parallel.fused_count() == serial.fused_count());
+    for (int out : outs) {
+        const auto a = grid_output(serial, out, "value");
+        const auto b = grid_output(parallel, out, "value");
+        REQUIRE(a);
+        REQUIRE(b);
+        bool same = a->width() == b->width() && a->height() == b->height();
+        for (int y = 0; y < a->height() && same; ++y)
+            for (int x = 0; x < a->width() && same; ++x)
+                same = a->get(x, y) == b->get(x, y);
+        CHECK(same);
+    }
+
+    // Every type that ran has a measured cost now.
+    CHECK(parallel.costs().predict("node_cellular_automata", 64 * 64));
+    CHECK(parallel.costs().predict("node_noise_grid", 64 * 64));
+}
+
+TEST_CASE("eval_engine: long chains start first", "[graph]") {
+    node_graph g;
+    std::vector<int> cheap;
+    for (int i = 0; i < 6; ++i) cheap.push_back(g.add_node(std::make_unique<node_test_cheap>()));
+    std::vector<int> chain;
+    for (int i = 0; i < 4; ++i) {
+        chain.push_back(g.add_node(std::make_unique<node_test_slow>()));
+        if (i > 0) g.add_wire({ chain[i - 1], "out", chain[i], "in" });
+    }
+
+    eval_engine engine;
+    engine.costs().record(typeid(node_test_slow).name(), 0, 1000);
+    engine.costs().record(typeid(node_test_cheap).name(), 0, 10);
+
+    const auto t = engine.estimate_time(g);
+    CHECK(t.total_us == 4060);
+    CHECK(t.critical_path_us == 4000);
+    CHECK(t.wall_us(2) == 4000);
+    CHECK(engine.estimate_node_us(g, chain[0]) == 1000);
+
+    g_started.clear();
+    engine.set_threads(2);
+    engine.evaluate(g);
+    REQUIRE(g_started.size() == 10);
+    const auto head = std::find(g_started.begin(), g_started.end(), chain[0]) - g_started.begin();
+    CHECK(head < 2);
+    CHECK(std::get<double>(*engine.get_output(chain.back(), "out")) == 3);
+}
+
+TEST_CASE("eval_engine: exceptions from parallel nodes reach the caller", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    g.add_node(reg.create("node_create_grid"));
+    g.add_node(reg.create("node_cellular_automata"));     // no input grid: throws
+
+    eval_engine engine;
+    engine.set_threads(2);
+    CHECK_THROWS(engine.evaluate(g));
+}
+
+// ---- region evaluation --------------------------------------------------
+
+namespace {
+
+// Copies its input; declares no reach.
+struct node_test_copy final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc = { .pins = {
+            { "input",  pin_direction::input,  pin_type::grid },
+            { "output", pin_direction::output, pin_type::grid },
+        }, .flags = node_flag_pure | node_flag_thread_safe };
+        return desc;
+    }
+    bool evaluate(eval_context& ctx) override {
+        ctx.set_output_grid("output", std::make_shared<grid>(ctx.input_grid("input")));
+        return true;
+    }
+};
+
+struct world {
+    node_graph graph;
+    int noise = 0, ca = 0, out = 0;
+};
+
+// 128x128 create -> noise -> cellular automata -> threshold -> output.
+world make_world() {
+    auto& reg = node_registry::instance();
+    world w;
+    const int create = w.graph.add_node(reg.create("node_create_grid"));
+    width_setter wide(128);
+    w.graph.find_node(create)->accept(wide);
+    number_setter tall("height", 128);
+    w.graph.find_node(create)->accept(tall);
+    w.noise = w.graph.add_node(reg.create("node_noise_grid"));
+    w.ca    = w.graph.add_node(reg.create("node_cellular_automata"));
+    const int th = add_threshold(w.graph, 1, 2, 3);
+    w.out   = w.graph.add_node(reg.create("node_output_grid"));
+    w.graph.add_wire({ create, "grid",   w.noise, "grid" });
+    w.graph.add_wire({ w.noise, "grid",  w.ca,    "input" });
+    w.graph.add_wire({ w.ca,   "output", th,      "input" });
+    w.graph.add_wire({ th,     "output", w.out,   "value" });
+    return w;
+}
+
+bool same_cells(const grid& chunk, const grid& whole, int ox, int oy) {
+    for (int y = 0; y < chunk.height(); ++y)
+        for (int x = 0; x < chunk.width(); ++x)
+            if (chunk.get(x, y) != whole.get(ox + x, oy + y)) return false;
+    return true;
+}
+
+} // anonymous namespace
+
+TEST_CASE("eval_engine: regions match the same cells of the whole grid", "[graph]") {
+    world w = make_world();
+    eval_engine full;
+    full.evaluate(w.graph, 9);
+    const auto whole = grid_output(full, w.out, "value");
+    REQUIRE(whole);
+    REQUIRE(whole->width() == 128);
+
+    eval_engine chunks;
+    for (const rect r : { rect{ 40, 40, 16, 16 }, rect{ 56, 40, 16, 16 }, rect{ 40, 56, 24, 8 } }) {
+        chunks.evaluate_region(w.graph, r, 9);
+        const auto chunk = grid_output(chunks, w.out, "value");
+        REQUIRE(chunk);
+        CHECK(chunk->width() == r.width);
+        CHECK(chunk->height() == r.height);
+        CHECK(same_cells(*chunk, *whole, r.x, r.y));
+    }
+
+    // Upstream of the 5-iteration automaton, grids carry a 5-cell margin.
+    const auto noise = grid_output(chunks, w.noise, "grid");
+    REQUIRE(noise);
+    CHECK(noise->width() == 24 + 10);
+    CHECK(noise->height() == 8 + 10);
+
+    // The same region again changes nothing.
+    chunks.evaluate_region(w.graph, { 40, 56, 24, 8 }, 9);
+    CHECK(chunks.reused_count() == int(w.graph.node_ids().size()));
+}
+
+TEST_CASE("eval_engine: number inputs set the reach of a region", "[graph]") {
+    world w = make_world();
+    const int iterations = add_constant(w.graph, 2);
+    w.graph.add_wire({ iterations, "value", w.ca, "iterations" });
+
+    eval_engine full;
+    full.evaluate(w.graph, 4);
+    eval_engine chunk;
+    chunk.evaluate_region(w.graph, { 64, 10, 16, 16 }, 4);
+    REQUIRE(grid_output(chunk, w.noise, "grid"));
+    CHECK(grid_output(chunk, w.noise, "grid")->width() == 16 + 4);
+    CHECK(same_cells(*grid_output(chunk, w.out, "value"), *grid_output(full, w.out, "value"), 64, 10));
+}
+
+TEST_CASE("eval_engine: nodes of unknown reach can't be evaluated by region", "[graph]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int copy   = g.add_node(std::make_unique<node_test_copy>());
+    g.add_wire({ create, "grid", copy, "input" });
+
+    eval_engine engine;
+    CHECK_THROWS(engine.evaluate_region(g, { 0, 0, 8, 8 }));
+    CHECK_NOTHROW(engine.evaluate(g));
+}
+
+// ---- progressive preview ------------------------------------------------
+
+namespace {
+
+// Cancels `token` when evaluated.
+struct node_test_canceller final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc = { .pins = {
+            { "out", pin_direction::output, pin_type::number },
+        } };
+        return desc;
+    }
+    bool evaluate(eval_context& ctx) override {
+        token->cancel();
+        ctx.set_output_number("out", 0);
+        return true;
+    }
+    static inline const cancel_token* token = nullptr;
+};
+
+} // anonymous namespace
+
+TEST_CASE("eval_engine: progressive levels refine to full resolution", "[graph]") {
+    world w = make_world();
+    eval_engine engine;
+    std::vector<std::pair<int, int>> levels;     // divisor, output width
+    const bool done = engine.evaluate_progressive(w.graph, 3, [&](const eval_engine& level, int divisor) {
+        levels.emplace_back(divisor, grid_output(level, w.out, "value")->width());
+    });
+    CHECK(done);
+    CHECK(levels == std::vector<std::pair<int, int>>{ { 4, 32 }, { 2, 64 }, { 1, 128 } });
+    REQUIRE(engine.preview(2));
+    CHECK(grid_output(*engine.preview(2), w.out, "value")->height() == 64);
+    CHECK(engine.preview(1) == &engine);
+
+    // Full resolution is an ordinary evaluation.
+    eval_engine plain;
+    plain.evaluate(w.graph, 3);
+    CHECK(same_cells(*grid_output(engine, w.out, "value"), *grid_output(plain, w.out, "value"), 0, 0));
+
+    // Each level keeps its own cache.
+    engine.evaluate_progressive(w.graph, 3, {});
+    CHECK(engine.preview(4)->reused_count() == int(w.graph.node_ids().size()));
+    CHECK(engine.reused_count() == int(w.graph.node_ids().size()));
+
+    CHECK(eval_context{}.spatial(5) == 5);
+}
+
+TEST_CASE("eval_engine: cancelling stops progressive evaluation", "[graph]") {
+    world w = make_world();
+    eval_engine engine;
+    cancel_token cancel;
+    int delivered = 0;
+    const bool done = engine.evaluate_progressive(w.graph, 0, [&](const eval_engine&, int) {
+        ++delivered;
+        cancel.cancel();            // the input changed again
+    }, cancel);
+    CHECK_FALSE(done);
+    CHECK(delivered == 1);
+    CHECK(engine.preview(4));
+    CHECK_FALSE(engine.preview(2));
+
+    // Cancelled mid-level, on several threads: nothing more runs.
+    node_graph g;
+    const int first = g.add_node(std::make_unique<node_test_canceller>());
+    int prev = first;
+    for (int i = 0; i < 4; ++i) {
+        const int step = g.add_node(std::make_unique<node_test_cheap>());
+        g.add_wire({ prev, "out", step, "in" });
+        prev = step;
+    }
+    cancel_token mid;
+    node_test_canceller::token = &mid;
+    g_started.clear();
+    engine.set_threads(2);
+    CHECK_FALSE(engine.evaluate_progressive(g, 1, [&](const eval_engine&, int) { ++delivered; }, mid));
+    CHECK(delivered == 1);
+    CHECK(g_started.empty());
+}
+
+TEST_CASE("generator: progressive outputs by divisor", "[graph]") {
+    generator gen;
+    world w = make_world();
+    gen.graph() = std::move(w.graph);
+    gen.graph().find_node(w.out)->set_name("map");
+    gen.rebuild_bindings();
+
+    std::vector<int> widths;
+    CHECK(gen.evaluate_progressive([&](int divisor) { widths.push_back(gen.get_grid_output("map", divisor)->width()); }));
+    CHECK(widths == std::vector<int>{ 32, 64, 128 });
+    CHECK(gen.get_grid_output("map")->width() == 128);
+}
+
+// ---- asynchronous evaluation --------------------------------------------
+
+TEST_CASE("generator: asynchronous evaluation reports progress", "[graph]") {
+    generator gen;
+    world w = make_world();
+    gen.graph() = std::move(w.graph);
+    gen.graph().find_node(w.out)->set_name("map");
+    gen.rebuild_bindings();
+
+    evaluation e = gen.evaluate_async();
+    CHECK(e.wait());
+    CHECK(e.ready());
+    CHECK(e.total() == 5);
+    CHECK(e.completed() == 5);
+    REQUIRE(gen.get_grid_output("map"));
+    CHECK(gen.get_grid_output("map")->width() == 128);
+
+    evaluation idle;
+    CHECK(idle.ready());
+    CHECK_FALSE(idle.wait());
+}
+
+TEST_CASE("generator: cancelling stops inside long nodes", "[graph]") {
+    generator gen;
+    world w = make_world();
+    gen.graph() = std::move(w.graph);
+    gen.graph().find_node(w.out)->set_name("map");
+    number_setter slow("iterations", 100000);
+    gen.graph().find_node(w.ca)->accept(slow);
+    gen.rebuild_bindings();
+
+    evaluation e = gen.evaluate_async();
+    while (e.completed() < 2) std::this_thread::yield();   // into the automaton
+    e.cancel();
+    CHECK_FALSE(e.wait());
+    CHECK(e.completed() < e.total());
+    CHECK_FALSE(gen.get_grid_output("map"));
+
+    // What finished is kept for the next run.
+    number_setter quick("iterations", 1);
+    gen.graph().find_node(w.ca)->accept(quick);
+    gen.evaluate();
+    CHECK(gen.engine().reused_count() == 2);
+    CHECK(gen.get_grid_output("map"));
+}
+
+// ---- frame-budgeted evaluation ------------------------------------------
+
+TEST_CASE("eval_engine: stepping spreads an evaluation over frames", "[graph]") {
+    world w = make_world();
+    eval_engine plain;
+    plain.evaluate(w.graph, 6);
+
+    eval_engine stepped;
+    CHECK(stepped.step(100));                   // nothing in progress
+    stepped.begin_steps(w.graph, 6);
+    CHECK(stepped.stepping());
+    int frames = 0;
+    while (!stepped.step(0)) ++frames;          // one node or one automaton row per frame
+    ++frames;
+    CHECK_FALSE(stepped.stepping());
+    CHECK(stepped.last_step_stats().frames == frames);
+    CHECK(frames > 5 * 128);                    // resumed inside the 5-iteration automaton
+    CHECK(same_cells(*grid_output(stepped, w.out, "value"), *grid_output(plain, w.out, "value"), 0, 0));
+
+    // A generous budget finishes in one frame.
+    stepped.begin_steps(w.graph, 7);
+    CHECK(stepped.step(1e9));
+    CHECK(stepped.last_step_stats().frames == 1);
+}
+
+TEST_CASE("generator: step starts and finishes generations", "[graph]") {
+    generator gen;
+    world w = make_world();
+    gen.graph() = std::move(w.graph);
+    gen.graph().find_node(w.out)->set_name("map");
+    gen.rebuild_bindings();
+
+    int frames = 1;
+    while (!gen.step(50)) ++frames;
+    CHECK(gen.engine().last_step_stats().frames == frames);
+    CHECK(gen.engine().last_step_stats().busy_us > 0);
+    REQUIRE(gen.get_grid_output("map"));
+    CHECK(gen.get_grid_output("map")->width() == 128);
+}
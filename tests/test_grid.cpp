@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+#include <level_synth/grid.hpp>
+#include <level_synth/grid_file.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace ls;
+
+// ---- grid_stats ---------------------------------------------------------
+
+TEST_CASE("grid stats: numeric range and histogram", "[grid]") {
+    grid g(4, 4, tag::numeric(0));
+    g.set(1, 1, tag::numeric(5));
+    g.set(2, 2, tag::numeric(-3));
+    g.set(3, 3, tag::numeric(5));
+
+    const auto& s = g.stats();
+    CHECK(s.numeric_count == 16);
+    CHECK(s.min_value == -3);
+    CHECK(s.max_value == 5);
+    CHECK(s.histogram.size() == 3);
+    CHECK(s.count(tag::numeric(0)) == 13);
+    CHECK(s.count(tag::numeric(5)) == 2);
+    CHECK(s.count(tag::numeric(-3)) == 1);
+    CHECK(s.count(tag::numeric(7)) == 0);
+    CHECK(s.symbolic_tags.empty());
+}
+
+TEST_CASE("grid stats: distinct symbolic tags", "[grid]") {
+    const tag wall  = tag::symbolic(1, 0, 0);
+    const tag floor = tag::symbolic(2, 0, 0);
+
+    grid g(3, 2, wall);
+    g.set(0, 1, floor);
+    g.set(1, 1, tag::numeric(9));
+
+    const auto& s = g.stats();
+    REQUIRE(s.symbolic_tags.size() == 2);
+    CHECK(s.symbolic_tags[0] == wall);
+    CHECK(s.symbolic_tags[1] == floor);
+    CHECK(s.numeric_count == 1);
+    CHECK(s.min_value == 9);
+    CHECK(s.max_value == 9);
+    CHECK(s.count(wall) == 4);
+}
+
+TEST_CASE("grid stats: invalidated by mutation", "[grid]") {
+    grid g(3, 3, tag::numeric(1));
+    CHECK(g.stats().max_value == 1);
+
+    g.set(0, 0, tag::numeric(4));
+    CHECK(g.stats().max_value == 4);
+
+    g(1, 1) = tag::numeric(8);
+    CHECK(g.stats().max_value == 8);
+
+    g.fill(tag::numeric(2));
+    CHECK(g.stats().min_value == 2);
+    CHECK(g.stats().max_value == 2);
+    CHECK(g.stats().count(tag::numeric(2)) == 9);
+}
+
+TEST_CASE("grid stats: copies keep their own cache", "[grid]") {
+    grid a(2, 2, tag::numeric(1));
+    CHECK(a.stats().max_value == 1);
+
+    grid b(a);
+    b.set(0, 0, tag::numeric(3));
+    CHECK(a.stats().max_value == 1);
+    CHECK(b.stats().max_value == 3);
+}
+
+// ---- grid files ---------------------------------------------------------
+
+namespace {
+
+grid make_level(int w, int h) {
+    grid g(w, h, tag::numeric(0));
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if ((x / 3 + y / 2) % 4 == 0) g.set(x, y, tag::numeric(1));
+    g.set(w - 1, h - 1, tag::symbolic(7, 3, 0));
+    return g;
+}
+
+bool same_cells(const grid& g, const grid_view& v) {
+    if (g.width() != v.width() || g.height() != v.height()) return false;
+    for (int y = 0; y < g.height(); ++y)
+        for (int x = 0; x < g.width(); ++x)
+            if (g.get(x, y) != v.get(x, y)) return false;
+    return true;
+}
+
+} // anonymous namespace
+
+TEST_CASE("grid file: every storage and compression round trips", "[grid]") {
+    const grid g = make_level(37, 70);
+
+    for (auto storage : { grid_storage::raw, grid_storage::palette8, grid_storage::palette16 }) {
+        for (auto compression : { grid_compression::none, grid_compression::rle }) {
+            grid_file_options o;
+            o.auto_storage = false;
+            o.storage      = storage;
+            o.compression  = compression;
+            o.chunk_rows   = 16;
+            const auto bytes = encode_grid(g, o);
+            const auto f = grid_file::from_memory(bytes.data(), bytes.size());
+            CHECK(f.view().storage() == storage);
+            CHECK(same_cells(g, f.view()));
+        }
+    }
+}
+
+TEST_CASE("grid file: auto storage and compression size", "[grid]") {
+    const grid g = make_level(64, 64);
+    const auto plain = encode_grid(g);
+    grid_file_options o;
+    o.compression = grid_compression::rle;
+    const auto packed = encode_grid(g, o);
+
+    CHECK(grid_file::from_memory(plain.data(), plain.size()).view().storage() == grid_storage::palette8);
+    CHECK(plain.size() < size_t(64 * 64 * 8));
+    CHECK(packed.size() < plain.size());
+}
+
+TEST_CASE("grid file: incompressible bands stay in place", "[grid]") {
+    // Top band one tag, bottom band every cell different.
+    grid g(16, 32, tag::numeric(0));
+    for (int y = 16; y < 32; ++y)
+        for (int x = 0; x < 16; ++x)
+            g.set(x, y, tag::numeric(y * 16 + x));
+
+    grid_file_options o;
+    o.auto_storage = false;
+    o.storage      = grid_storage::palette16;
+    o.compression  = grid_compression::rle;
+    o.chunk_rows   = 16;
+    const auto bytes = encode_grid(g, o);
+    const auto f = grid_file::from_memory(bytes.data(), bytes.size());
+    CHECK(same_cells(g, f.view()));
+    CHECK(f.decoded_bytes() == size_t(16 * 16 * 2));     // just the top band
+
+    const auto plain = encode_grid(g, { .auto_storage = false, .storage = grid_storage::palette16 });
+    CHECK(grid_file::from_memory(plain.data(), plain.size()).decoded_bytes() == 0);
+}
+
+TEST_CASE("grid file: mapped from disk", "[grid]") {
+    const grid g = make_level(20, 9);
+    const std::string path = "level_synth_test_grid.lsgr";
+    save_grid(g, path);
+    {
+        grid_file f = grid_file::open(path);
+        CHECK(same_cells(g, f.view()));
+
+        grid_file moved = std::move(f);
+        CHECK(moved.view().to_grid().get(19, 8) == tag::symbolic(7, 3, 0));
+    }
+    std::remove(path.c_str());
+
+    CHECK_THROWS_AS(grid_file::open("does_not_exist.lsgr"), std::runtime_error);
+}
+
+TEST_CASE("grid file: malformed data throws", "[grid]") {
+    grid_file_options o;
+    o.compression = grid_compression::rle;
+    auto bytes = encode_grid(make_level(10, 10), o);
+
+    CHECK_THROWS_AS(grid_file::from_memory(bytes.data(), 10), std::runtime_error);
+    CHECK_THROWS_AS(grid_file::from_memory(bytes.data(), bytes.size() - 1), std::runtime_error);
+
+    auto bad = bytes;
+    bad[0] = 'X';
+    CHECK_THROWS_AS(grid_file::from_memory(bad.data(), bad.size()), std::runtime_error);
+}
+
+TEST_CASE("grid file: inflated dimensions throw before allocating", "[grid]") {
+    grid_file_options o;
+    o.compression = grid_compression::rle;
+    auto bytes = encode_grid(make_level(10, 10), o);
+    auto put_u32 = [&](size_t at, uint32_t v) {
+        for (int b = 0; b < 4; ++b) bytes[at + b] = uint8_t(v >> (8 * b));
+    };
+
+    // 2^20 x 2^20 cells in one band: within the header's limit, but the
+    // band holds only the original 100 cells.
+    put_u32(8, 1u << 20);       // width
+    put_u32(12, 1u << 20);      // height
+    put_u32(24, 1u << 20);      // chunk rows
+    CHECK_THROWS_AS(grid_file::from_memory(bytes.data(), bytes.size()), std::runtime_error);
+
+    // Truncated just past the header.
+    CHECK_THROWS_AS(grid_file::from_memory(bytes.data(), 70), std::runtime_error);
+}
@@ -0,0 +1,160 @@
+#include <catch2/catch_test_macros.hpp>
+#include <level_synth/eval_engine.hpp>
+#include <level_synth/node.hpp>
+#include <level_synth/node_graph.hpp>
+#include <level_synth/node_registry.hpp>
+#include <level_synth/plugin_loader.hpp>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+using namespace ls;
+
+namespace {
+
+// Writes a manifest into a fresh temporary directory and returns its path.
+std::filesystem::path write_manifest(const std::string& name, const std::string& body) {
+    const auto dir = std::filesystem::temp_directory_path() / "level_synth_plugin_tests";
+    std::filesystem::create_directories(dir);
+    const auto path = dir / (name + ".lsplugin");
+    std::ofstream(path) << body;
+    return path;
+}
+
+std::string manifest_for(const std::string& library, const std::string& type, int abi = 1) {
+    return R"({ "abi_version": )" + std::to_string(abi)
+         + R"(, "library": )" + nlohmann::json(library).dump()
+         + R"(, "nodes": [ { "type": ")" + type + R"(", "display_name": "Plugin Constant" } ] })";
+}
+
+// Stands in for a plugin's node types; each N is a distinct C++ type, as
+// each plugin type is.
+template <int N>
+struct node_test_resolved final : node {
+    const node_descriptor& descriptor() const override {
+        static node_descriptor desc;
+        return desc;
+    }
+    bool evaluate(eval_context&) override { return true; }
+};
+
+template <int... N>
+std::unordered_map<std::string, node_registration> resolved_types(std::integer_sequence<int, N...>) {
+    std::unordered_map<std::string, node_registration> types;
+    (types.emplace("node_test_resolved_" + std::to_string(N),
+                   node_registration{ "node_test_resolved_" + std::to_string(N), "Resolved", "Plugins",
+                                      [] { return std::make_unique<node_test_resolved<N>>(); },
+                                      typeid(node_test_resolved<N>) }), ...);
+    return types;
+}
+
+} // anonymous namespace
+
+TEST_CASE("plugins: a manifest defers loading until a graph uses the type", "[plugin]") {
+    auto& reg = node_registry::instance();
+    plugin_loader loader;
+    loader.add_manifest(write_manifest("constant", manifest_for(LS_TEST_PLUGIN_PATH, "node_plugin_constant")));
+
+    REQUIRE(loader.plugins().size() == 1);
+    CHECK_FALSE(loader.plugins()[0].loaded);
+    CHECK(loader.pending_types().size() == 1);
+    CHECK(loader.pending_types()[0].category == "Plugins");
+    CHECK_FALSE(reg.entries().contains("node_plugin_constant"));
+
+    // Without the resolver the registry doesn't know the type.
+    CHECK_THROWS_AS(reg.create("node_plugin_constant"), std::runtime_error);
+
+    loader.install();
+    node_graph g;
+    g.load(R"({ "nodes": [ { "id": 0, "type": "node_plugin_constant" } ], "wires": [], "next_id": 1 })");
+
+    CHECK(loader.plugins()[0].loaded);
+    CHECK(loader.pending_types().empty());
+    REQUIRE(g.find_node(0));
+    CHECK(reg.find(*g.find_node(0))->type_name == "node_plugin_constant");
+    CHECK(reg.find("node_plugin_constant")->display_name == "Plugin Constant");
+}
+
+TEST_CASE("plugins: loading directly is idempotent", "[plugin]") {
+    plugin_loader loader;
+    loader.load(LS_TEST_PLUGIN_PATH);
+    loader.load(LS_TEST_PLUGIN_PATH);
+    CHECK(loader.plugins().size() == 1);
+    CHECK(node_registry::instance().create("node_plugin_constant"));
+}
+
+TEST_CASE("plugins: bad manifests and libraries are reported", "[plugin]") {
+    plugin_loader loader;
+    CHECK_THROWS_AS(loader.add_manifest(write_manifest("old_abi", manifest_for("x.so", "node_old", 0))),
+                    std::runtime_error);
+    CHECK_THROWS_AS(loader.add_manifest(write_manifest("broken", "{ \"abi_version\": 1, ")),
+                    std::runtime_error);
+    CHECK_THROWS_AS(loader.load("does_not_exist.so"), std::runtime_error);
+
+    loader.add_manifest(write_manifest("missing", manifest_for("does_not_exist.so", "node_missing")));
+    loader.install();
+    CHECK_THROWS_AS(node_registry::instance().create("node_missing"), std::runtime_error);
+    CHECK(loader.errors().size() == 1);
+
+    // A failed plugin isn't retried on every lookup.
+    CHECK_FALSE(node_registry::instance().find("node_missing"));
+    CHECK(loader.errors().size() == 1);
+}
+
+TEST_CASE("plugins: scan reads only manifests and collects failures", "[plugin]") {
+    const auto dir = std::filesystem::temp_directory_path() / "level_synth_plugin_scan";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "a.lsplugin") << manifest_for("a.so", "node_a");
+    std::ofstream(dir / "b.lsplugin") << manifest_for("b.so", "node_b", 99);
+    std::ofstream(dir / "readme.txt") << "not a manifest";
+
+    plugin_loader loader;
+    CHECK(loader.scan(dir) == 1);
+    CHECK(loader.errors().size() == 1);
+    REQUIRE(loader.plugins().size() == 1);
+    CHECK(loader.plugins()[0].library == dir / "a.so");
+    CHECK(loader.scan(dir / "nope") == 0);
+}
+
+TEST_CASE("plugins: types resolve while a worker evaluates", "[plugin]") {
+    auto& reg = node_registry::instance();
+    auto pending = resolved_types(std::make_integer_sequence<int, 64>{});
+    reg.set_resolver([&](const std::string& type_name) {
+        auto it = pending.find(type_name);
+        if (it == pending.end()) return false;
+        reg.register_node(std::move(it->second));
+        pending.erase(it);
+        return true;
+    });
+
+    // The engine looks up node types for its cost model as nodes run, as
+    // the editor's background evaluator does while the UI loads graphs.
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int ca     = g.add_node(reg.create("node_cellular_automata"));
+    g.add_wire({ create, "grid", ca, "input" });
+
+    std::atomic<bool> stop = false;
+    std::atomic<int> runs = 0;
+    std::thread worker([&] {
+        eval_engine engine;
+        while (!stop) {
+            engine.invalidate_all();
+            engine.evaluate(g);
+            ++runs;
+        }
+    });
+    while (runs == 0) std::this_thread::yield();
+    for (int i = 0; i < 64; ++i)
+        CHECK(reg.create("node_test_resolved_" + std::to_string(i)));
+    stop = true;
+    worker.join();
+    reg.set_resolver(nullptr);
+    CHECK(pending.empty());
+}
@@ -0,0 +1,273 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <level_synth/json_stream.hpp>
+#include <level_synth/json_visitor.hpp>
+#include <level_synth/lz.hpp>
+#include <level_synth/node_graph.hpp>
+#include <level_synth/node_registry.hpp>
+#include <level_synth/node_visitor.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace ls;
+
+namespace {
+
+// Sets every tag member it visits; json_writer has no tag support, so this
+// is the only way to give a node a non-default tag from outside.
+struct tag_setter final : node_visitor {
+    tag value;
+    explicit tag_setter(tag t) : value(t) {}
+    void visit(std::string_view, tag& t) override { t = value; }
+};
+
+// Reads back the first tag member it visits.
+struct tag_getter final : node_visitor {
+    tag value;
+    void visit(std::string_view, tag& t) override { value = t; }
+};
+
+node_graph make_sample_graph() {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    const int create = g.add_node(reg.create("node_create_grid"));
+    const int noise  = g.add_node(reg.create("node_noise_grid"));
+    const int ca     = g.add_node(reg.create("node_cellular_automata"));
+    const int out    = g.add_node(reg.create("node_output_grid"));
+    g.find_node(noise)->set_position({ 120.5f, -40.0f });
+    g.find_node(ca)->set_name("Smooth caves");
+
+    tag_setter fill(tag::numeric(3));
+    g.find_node(create)->accept(fill);
+
+    g.add_wire({ create, "grid", noise, "grid" });
+    g.add_wire({ noise,  "grid", ca,    "input" });
+    g.add_wire({ ca,     "output", out, "value" });
+    return g;
+}
+
+// `copies` chains of the sample graph side by side.
+node_graph make_large_graph(int copies) {
+    node_graph g;
+    const std::string clip = make_sample_graph().save();
+    for (int i = 0; i < copies; ++i) g.paste_subgraph(clip, 0.0f, float(i) * 200.0f);
+    return g;
+}
+
+} // anonymous namespace
+
+TEST_CASE("binary graph: round trip matches json", "[serialization]") {
+    node_graph g = make_sample_graph();
+    const auto bytes = g.save_binary();
+
+    node_graph loaded;
+    loaded.load_binary(bytes);
+
+    CHECK(loaded.save() == g.save());
+    CHECK(loaded.wires().size() == 3);
+    CHECK(loaded.find_node(1)->position() == vec2{ 120.5f, -40.0f });
+    CHECK(loaded.find_node(2)->name() == "Smooth caves");
+
+    tag_getter fill;
+    loaded.find_node(0)->accept(fill);
+    CHECK(fill.value == tag::numeric(3));
+
+    // Writing is deterministic, so a reload saves the same bytes.
+    CHECK(loaded.save_binary() == bytes);
+
+    // Fresh ids continue after the loaded ones.
+    CHECK(loaded.add_node(node_registry::instance().create("node_input_number")) == 4);
+}
+
+TEST_CASE("binary graph: malformed data throws", "[serialization]") {
+    node_graph g = make_sample_graph();
+    auto bytes = g.save_binary();
+
+    node_graph loaded;
+    for (size_t n : { size_t(0), size_t(3), size_t(12), bytes.size() / 2, bytes.size() - 1 })
+        CHECK_THROWS_AS(loaded.load_binary(bytes.data(), n), std::runtime_error);
+
+    auto bad_magic = bytes;
+    bad_magic[0] = 'X';
+    CHECK_THROWS_AS(loaded.load_binary(bad_magic), std::runtime_error);
+
+    auto bad_version = bytes;
+    bad_version[4] = 99;
+    CHECK_THROWS_AS(loaded.load_binary(bad_version), std::runtime_error);
+
+    CHECK_NOTHROW(loaded.load_binary(bytes));
+}
+
+TEST_CASE("binary graph: malformed data leaves the graph untouched", "[serialization]") {
+    node_graph g = make_sample_graph();
+    const auto bytes = g.save_binary();
+    const std::string before = g.save();
+
+    // Cut off in the wire table, after every node has been read.
+    CHECK_THROWS_AS(g.load_binary(bytes.data(), bytes.size() - 6), std::runtime_error);
+    CHECK(g.save() == before);
+
+    // A huge count with nothing behind it throws before allocating.
+    std::vector<uint8_t> huge(bytes.begin(), bytes.begin() + 8);
+    for (uint8_t b : { 0xff, 0xff, 0xff, 0x7f }) huge.push_back(b);
+    CHECK_THROWS_AS(g.load_binary(huge), std::runtime_error);
+    CHECK(g.save() == before);
+}
+
+TEST_CASE("binary graph: duplicate ids throw and next_id skips loaded ids", "[serialization]") {
+    auto& reg = node_registry::instance();
+    node_graph g;
+    g.insert_node(0x01020304, reg.create("node_create_grid"));
+    g.insert_node(0x01020305, reg.create("node_create_grid"));
+    auto bytes = g.save_binary();
+    const uint8_t first[]  = { 0x04, 0x03, 0x02, 0x01 };
+    const uint8_t second[] = { 0x05, 0x03, 0x02, 0x01 };
+    auto find = [&](const uint8_t* pattern) {
+        return std::search(bytes.begin(), bytes.end(), pattern, pattern + 4);
+    };
+
+    // A next_id at or below a loaded id is raised past it.
+    auto next = bytes;
+    for (size_t i = next.size() - 4; i < next.size(); ++i) next[i] = 0;
+    node_graph loaded;
+    loaded.load_binary(next);
+    CHECK(loaded.add_node(reg.create("node_noise_grid")) == 0x01020306);
+    CHECK(loaded.node_ids().size() == 3);
+
+    // Two nodes under one id.
+    REQUIRE(find(second) != bytes.end());
+    std::copy(first, first + 4, find(second));
+    const std::string before = loaded.save();
+    CHECK_THROWS_AS(loaded.load_binary(bytes), std::runtime_error);
+    CHECK(loaded.save() == before);
+}
+
+TEST_CASE("json_emitter: layout matches dump(2)", "[serialization]") {
+    json_emitter out;
+    out.begin_object();
+    out.key("a"); out.value(1.5);
+    out.key("b");
+    out.begin_array(); out.value(1); out.value(64.0); out.value(-2.5e-7); out.end_array();
+    out.key("c"); out.begin_object(); out.end_object();
+    out.key("d"); out.value("tab\there \"quoted\" \x01");
+    out.key("e"); out.begin_array(); out.end_array();
+    out.key("f"); out.value(true);
+    out.key("g"); out.null();
+    out.end_object();
+
+    const auto text = out.take();
+    const auto dom  = nlohmann::json::parse(text);
+    CHECK(text == dom.dump(2));             // keys above are already sorted
+    CHECK(dom["b"][1].is_number_float());
+    CHECK(dom["d"] == "tab\there \"quoted\" \x01");
+
+    json_emitter compact(-1);
+    compact.begin_array(); compact.value(1); compact.begin_object(); compact.key("k"); compact.value(2); compact.end_object(); compact.end_array();
+    CHECK(compact.str() == "[1,{\"k\":2}]");
+}
+
+TEST_CASE("json graph: streamed save matches the DOM writer", "[serialization]") {
+    node_graph g = make_sample_graph();
+    const auto saved = nlohmann::json::parse(g.save());
+
+    CHECK(saved["type"] == "level_synth_graph");
+    REQUIRE(saved["nodes"].size() == 4);
+    REQUIRE(saved["wires"].size() == 3);
+    for (const auto& jn : saved["nodes"]) {
+        const node* n = g.find_node(jn["id"].get<int>());
+        REQUIRE(n);
+        nlohmann::json expected;
+        expected["id"]   = n->id();
+        expected["type"] = node_registry::instance().find(*n)->type_name;
+        json_writer writer(expected);
+        const_cast<node*>(n)->accept(writer);
+        CHECK(jn == expected);
+    }
+
+    node_graph loaded;
+    loaded.load(g.save());
+    CHECK(loaded.save() == g.save());
+}
+
+TEST_CASE("json graph: malformed input leaves the graph untouched", "[serialization]") {
+    node_graph g = make_sample_graph();
+    const std::string before = g.save();
+    const std::string truncated = before.substr(0, before.size() / 2);
+
+    CHECK_THROWS_AS(g.load(truncated), nlohmann::json::parse_error);
+    CHECK(g.save() == before);
+
+    CHECK_THROWS_AS(g.paste_subgraph(truncated), nlohmann::json::parse_error);
+    CHECK(g.node_ids().size() == 4);
+}
+
+TEST_CASE("json graph: subgraph paste remaps ids and wires", "[serialization]") {
+    node_graph g = make_sample_graph();
+    const std::string clip = g.save_subgraph({ 1, 2 });
+
+    const auto id_map = g.paste_subgraph(clip, 10.0f, 0.0f);
+    REQUIRE(id_map.size() == 2);
+    CHECK(id_map.at(1) == 4);
+    CHECK(id_map.at(2) == 5);
+    CHECK(g.find_node(4)->position() == vec2{ 130.5f, -40.0f });
+    CHECK(g.wires().size() == 4);
+    CHECK(g.wires().back().from_node == 4);
+    CHECK(g.wires().back().to_node == 5);
+}
+
+TEST_CASE("lz: round trips and shrinks graph json", "[serialization]") {
+    const std::string text = make_sample_graph().save();
+    const auto block = lz_compress(text);
+    CHECK(block.size() < text.size() / 2);
+    CHECK(lz_decompress_string(block, text.size()) == text);
+
+    // Edge cases: empty, shorter than a match, long runs, incompressible.
+    std::string noise(5000, '\0');
+    uint32_t x = 1;
+    for (auto& c : noise) { x = x * 1664525u + 1013904223u; c = char(x >> 24); }
+    for (const std::string& s : { std::string(), std::string("abc"), std::string(100000, 'a'), noise }) {
+        const auto b = lz_compress(s);
+        CHECK(lz_decompress_string(b, s.size()) == s);
+    }
+}
+
+TEST_CASE("lz: malformed blocks throw", "[serialization]") {
+    const std::string text = make_sample_graph().save();
+    auto block = lz_compress(text);
+
+    CHECK_THROWS_AS(lz_decompress_string(block, text.size() + 1), std::runtime_error);
+    CHECK_THROWS_AS(lz_decompress_string(block, text.size() - 1), std::runtime_error);
+
+    block.resize(block.size() / 2);
+    CHECK_THROWS_AS(lz_decompress_string(block, text.size()), std::runtime_error);
+}
+
+TEST_CASE("node_registry: find by node resolves every registered type", "[serialization]") {
+    auto& reg = node_registry::instance();
+    for (const auto& [name, entry] : reg.entries()) {
+        const auto n = reg.create(name);
+        const node_registration* found = reg.find(*n);
+        REQUIRE(found);
+        CHECK(found == &entry);
+        CHECK(found->type_name == name);
+    }
+}
+
+// Run with: level_synth_tests "[benchmark]"
+TEST_CASE("graph save throughput", "[.][benchmark]") {
+    const node_graph g = make_large_graph(250);     // 1000 nodes
+    const node* first = g.find_node(g.node_ids().front());
+
+    BENCHMARK("node_registry::find x1000") {
+        const node_registration* r = nullptr;
+        for (int i = 0; i < 1000; ++i) r = node_registry::instance().find(*first);
+        return r;
+    };
+    BENCHMARK("save json, 1000 nodes") {
+        return g.save();
+    };
+    BENCHMARK("save binary, 1000 nodes") {
+        return g.save_binary();
+    };
+}
@@ -135,3 +135,222 @@ TEST_CASE("tag_registry: removal", "[tag]") {
     CHECK_FALSE(reg.find("Wall").has_value());
     CHECK(reg.find("Floor").has_value());
 }
+
+// ---- bulk matching ------------------------------------------------------
+
+#include <level_synth/grid.hpp>
+#include <level_synth/tag_match.hpp>
+#include <level_synth/flat_map.hpp>
+
+#include <unordered_map>
+
+TEST_CASE("tag_match: bulk results agree with match()", "[tag]") {
+    const tag wall     = tag::symbolic(1, 0, 0);
+    const tag wall_dmg = tag::symbolic(1, 2, 0);
+    const tag floor    = tag::symbolic(4, 0, 0);
+    const tag palette[] = { wall, wall_dmg, floor, tag::numeric(1), tag::numeric(0), tag() };
+
+    // 70 wide so rows span a full word plus a partial one.
+    grid g(70, 5);
+    for (int y = 0; y < g.height(); ++y)
+        for (int x = 0; x < g.width(); ++x)
+            g.set(x, y, palette[(x * 7 + y * 3) % 6]);
+
+    for (tag pattern : { wall, wall_dmg, floor, tag::numeric(1), tag() }) {
+        size_t expected = 0;
+        auto mask = match_mask(g, pattern);
+        for (int y = 0; y < g.height(); ++y) {
+            for (int x = 0; x < g.width(); ++x) {
+                const bool m = match(g.get(x, y), pattern);
+                expected += m;
+                CHECK(mask.test(x, y) == m);
+            }
+        }
+        CHECK(match_count(g, pattern) == expected);
+        CHECK(mask.count() == expected);
+        CHECK(match_cells(g, pattern).size() == expected);
+    }
+}
+
+TEST_CASE("tag_match: regions are clipped and report grid coordinates", "[tag]") {
+    const tag wall = tag::symbolic(1, 0, 0);
+    grid g(8, 8, tag::numeric(0));
+    g.set(2, 3, wall);
+    g.set(6, 6, wall);
+    g.set(7, 7, wall);
+
+    CHECK(match_count(g, wall, { 0, 0, 4, 4 }) == 1);
+    CHECK(match_count(g, wall, { 5, 5, 10, 10 }) == 2);
+
+    auto cells = match_cells(g, wall, { 1, 1, 6, 6 });
+    REQUIRE(cells.size() == 2);
+    CHECK(cells[0] == cell_coord{ 2, 3 });
+    CHECK(cells[1] == cell_coord{ 6, 6 });
+
+    auto mask = match_mask(g, wall, { 2, 3, 2, 2 });
+    CHECK(mask.width() == 2);
+    CHECK(mask.test(0, 0));
+    CHECK(mask.count() == 1);
+}
+
+TEST_CASE("cell_mask: set operations", "[tag]") {
+    cell_mask a(70, 2), b(70, 2);
+    a.set(0, 0);
+    a.set(69, 1);
+    b.set(69, 1);
+    b.set(3, 0);
+
+    CHECK((a & b).count() == 1);
+    CHECK((a | b).count() == 3);
+    CHECK((a ^ b).count() == 2);
+    CHECK((~a).count() == 140 - 2);
+    CHECK(cell_mask(a).subtract(b).count() == 1);
+}
+
+TEST_CASE("tag_index: ancestors cover their descendants", "[tag]") {
+    const tag wall     = tag::symbolic(1, 0, 0);
+    const tag wall_dmg = tag::symbolic(1, 2, 0);
+    const tag wall_brk = tag::symbolic(1, 4, 0);
+    const tag floor    = tag::symbolic(4, 0, 0);
+
+    grid g(70, 3, floor);
+    g.set(0, 0, wall);
+    g.set(65, 1, wall_dmg);
+    g.set(66, 1, wall_dmg);
+    g.set(2, 2, wall_brk);
+    g.set(3, 2, tag::numeric(7));
+
+    const tag_index& idx = g.index();
+    CHECK(idx.tags().size() == 4);
+    CHECK(idx.count(wall) == 4);
+    CHECK(idx.count(wall_dmg) == 2);
+    CHECK(idx.count(floor) == 70 * 3 - 5);
+    CHECK(idx.count(tag::numeric(7)) == 0);
+    CHECK(idx.find(tag::symbolic(9, 0, 0)) == nullptr);
+
+    auto dmg = idx.cells(wall_dmg);
+    REQUIRE(dmg.size() == 2);
+    CHECK(dmg[0] == cell_coord{ 65, 1 });
+    CHECK(dmg[1] == cell_coord{ 66, 1 });
+
+    // Boolean queries compose on the masks.
+    CHECK((idx.mask(wall) & idx.mask(wall_dmg)).count() == 2);
+    CHECK(cell_mask(idx.mask(wall)).subtract(idx.mask(wall_dmg)).count() == 2);
+    CHECK((idx.mask(wall) | idx.mask(floor)).count() == 70 * 3 - 1);
+}
+
+TEST_CASE("tag_index: agrees with match_mask", "[tag]") {
+    grid g(37, 11, tag::numeric(0));
+    for (int y = 0; y < g.height(); ++y)
+        for (int x = 0; x < g.width(); ++x)
+            if ((x * 7 + y * 3) % 5 != 0)
+                g.set(x, y, tag::symbolic(1 + x % 3, y % 4, (x + y) % 2));
+
+    const tag patterns[] = {
+        tag::symbolic(1, 0, 0), tag::symbolic(2, 1, 0), tag::symbolic(3, 2, 1),
+        tag::symbolic(0, 1, 0), tag::symbolic(0, 0, 0), tag::symbolic(8, 0, 0),
+    };
+    for (tag p : patterns) {
+        CHECK(g.index().mask(p) == match_mask(g, p));
+        CHECK(g.index().count(p) == match_count(g, p));
+    }
+}
+
+TEST_CASE("tag_index: rebuilt after the grid changes", "[tag]") {
+    const tag wall = tag::symbolic(1, 0, 0);
+    grid g(4, 4, tag::numeric(0));
+    CHECK(g.index().count(wall) == 0);
+
+    g.set(1, 1, wall);
+    CHECK(g.index().count(wall) == 1);
+
+    grid copy = g;
+    copy.fill(wall);
+    CHECK(copy.index().count(wall) == 16);
+    CHECK(g.index().count(wall) == 1);
+}
+
+TEST_CASE("tag literals: built at compile time, agree with parse", "[tag]") {
+    using namespace ls::literals;
+    constexpr tag wall_dmg = "Wall.Damaged"_tag;
+    static_assert(wall_dmg.type() == tag_type::symbolic);
+    static_assert(wall_dmg.l0() == hash_segment("Wall"));
+    static_assert(wall_dmg.l2() == 0);
+    static_assert(match("Wall.Damaged.Left"_tag, "Wall"_tag));
+    static_assert(!parse_identifier("Wall..Damaged"));
+    static_assert(!parse_identifier("A.B.C.D"));
+    static_assert(!parse_identifier("Wall."));
+
+    tag_registry reg;
+    CHECK(reg.parse("Wall.Damaged") == wall_dmg);
+    REQUIRE(reg.add("Wall.Damaged"));
+    CHECK(reg.find("Wall.Damaged") == wall_dmg);
+    CHECK(reg.identifier("Wall"_tag) == "Wall");
+}
+
+TEST_CASE("tag_registry: conflicts reports segment collisions", "[tag]") {
+    tag_registry reg;
+    REQUIRE(reg.add("Wall.Damaged"));
+    CHECK_FALSE(reg.conflicts("Wall.Damaged"));
+    CHECK_FALSE(reg.conflicts("Floor.Cave"));
+
+    // Find a segment that lands on the same 21-bit hash as "Wall".
+    const uint32_t target = hash_segment("Wall");
+    std::string other;
+    for (uint32_t i = 0; other.empty(); ++i) {
+        std::string candidate = "s" + std::to_string(i);
+        if (hash_segment(candidate) == target) other = candidate;
+    }
+    CHECK(reg.conflicts(other + ".Damaged"));
+    CHECK_FALSE(reg.add(other));
+}
+
+TEST_CASE("tag_registry: colors are keyed by tag", "[tag]") {
+    using namespace ls::literals;
+    tag_registry reg;
+    REQUIRE(reg.add("Wall.Damaged"));
+    reg.set_color("Wall", 0xff0000ff);
+    reg.set_color("Floor", 0xff00ff00); // not registered: ignored
+
+    CHECK(reg.get_color("Wall"_tag) == 0xff0000ffu);
+    CHECK(reg.get_color("Wall") == 0xff0000ffu);
+    CHECK_FALSE(reg.get_color("Wall.Damaged"_tag));
+    CHECK_FALSE(reg.get_color("Floor"));
+    CHECK_FALSE(reg.get_color(tag()));
+    CHECK_FALSE(reg.get_color(tag::numeric(5)));
+
+    REQUIRE(reg.rename("Wall", "Rock"));
+    CHECK(reg.get_color("Rock") == 0xff0000ffu);
+    CHECK_FALSE(reg.get_color("Wall"_tag));
+
+    reg.clear_color("Rock");
+    CHECK_FALSE(reg.get_color("Rock"));
+}
+
+TEST_CASE("flat_map: agrees with unordered_map under churn", "[tag]") {
+    flat_map<uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> ref;
+
+    uint64_t state = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        // Few distinct keys so inserts and erases hit the same probe chains.
+        const uint64_t key = ((state >> 33) % 500 + 1) << 42;
+        if ((state >> 20) & 1) {
+            map[key] = state;
+            ref[key] = state;
+        } else {
+            CHECK(map.erase(key) == (ref.erase(key) == 1));
+        }
+    }
+
+    CHECK(map.size() == ref.size());
+    for (const auto& [k, v] : ref) {
+        REQUIRE(map.find(k) != nullptr);
+        CHECK(*map.find(k) == v);
+    }
+    size_t visited = 0;
+    map.for_each([&](uint64_t k, uint64_t) { visited += ref.count(k); });
+    CHECK(visited == ref.size());
+    CHECK_FALSE(map.contains(0));
+}